@@ -0,0 +1,234 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Minimal benchmark harness: timing, reporting and JSON output
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkPerfCounters.h>
+
+// std includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Gkyl {
+namespace Bench {
+
+  /* Prevents the compiler from optimizing away the computation of
+   * v, or hoisting it out of a timing loop */
+  template <typename T>
+  inline void keep(const T& v) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r"(&v) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &v;
+#endif
+  }
+
+  /* Options controlling benchmark runs */
+  struct Options {
+      int samples = 5; /* Number of timing samples per benchmark */
+      double minTime = 0.02; /* Minimum time (s) of each sample */
+      std::string filter; /* Only run benchmarks whose name contains this */
+      std::string json; /* File to write JSON results to ("-" for stdout) */
+      bool perf = false; /* Read hardware counters */
+      std::vector<PerfEvent> perfEvents; /* Hardware counters to read */
+  };
+
+  /* Result of a single benchmark */
+  struct Result {
+      std::string name; /* Benchmark name */
+      std::string type; /* Number type (or AD mode) used */
+      std::string base; /* Type of the primal benchmark to compare to */
+      std::vector<double> samples; /* ns/op of each sample */
+      double nsPerOp = 0; /* Median ns/op */
+      double ratio = 0; /* Ratio of nsPerOp to primal nsPerOp (0 if no primal) */
+      std::vector<std::pair<std::string, double> > counters; /* Hardware counts per op */
+  };
+
+  /* Median of a set of values */
+  inline double median(std::vector<double> v) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    std::size_t n = v.size();
+    return n%2 == 1 ? v[n/2] : 0.5*(v[n/2-1]+v[n/2]);
+  }
+
+  /* Collection of benchmarks of one suite, with command line parsing
+   * and output */
+  class Suite {
+    public:
+      Suite(const std::string& name, int argc, char **argv) : name(name) {
+        for (int i=1; i<argc; ++i) {
+          std::string a = argv[i];
+          if (a == "--samples" && i+1<argc) opts.samples = std::atoi(argv[++i]);
+          else if (a == "--min-time" && i+1<argc) opts.minTime = std::atof(argv[++i]);
+          else if (a == "--filter" && i+1<argc) opts.filter = argv[++i];
+          else if (a == "--json" && i+1<argc) opts.json = argv[++i];
+          else if (a == "--perf") opts.perf = true;
+          else if (a == "--perf-raw" && i+1<argc) {
+            PerfEvent ev;
+            if (!PerfCounters::parseRaw(argv[++i], ev)) {
+              std::fprintf(stderr, "Bad raw event %s: use name=0xCODE\n", argv[i]);
+              std::exit(1);
+            }
+            opts.perf = true;
+            opts.perfEvents.push_back(ev);
+          }
+          else {
+            std::fprintf(stderr,
+              "Usage: %s [--samples N] [--min-time sec] [--filter str] [--json file|-]\n"
+              "         [--perf] [--perf-raw name=0xCODE ...]\n", argv[0]);
+            std::exit(a == "-h" || a == "--help" ? 0 : 1);
+          }
+        }
+        if (opts.samples < 1) opts.samples = 1;
+        if (opts.perf) {
+          std::vector<PerfEvent> ev = PerfCounters::defaultEvents();
+          ev.insert(ev.end(), opts.perfEvents.begin(), opts.perfEvents.end());
+          perf.reset(new PerfCounters(ev));
+          if (perf->events().empty())
+            std::fprintf(stderr, "No hardware counters available\n");
+        }
+      }
+
+      /* Benchmark options */
+      const Options& options() const { return opts; }
+
+      /* Times f(), which performs nops operations, for the benchmark
+       * 'name' using number type 'type'. 'base' is the type of the
+       * primal benchmark of the same name to compute the overhead
+       * ratio against (empty if this is a primal benchmark) */
+      template <typename F>
+      void run(const std::string& bname, const std::string& type, const std::string& base,
+        long nops, F f) {
+        if (!opts.filter.empty() && bname.find(opts.filter) == std::string::npos)
+          return;
+
+        // calibrate number of repetitions to get samples of minTime
+        f();
+        long reps = 1;
+        while (true) {
+          double t = time(f, reps);
+          if (t >= opts.minTime || reps >= (1L<<30)) break;
+          reps = t > 0 ? std::max(2*reps, (long) (1.2*reps*opts.minTime/t)) : 2*reps;
+        }
+
+        Result r;
+        r.name = bname; r.type = type; r.base = base;
+        for (int s=0; s<opts.samples; ++s)
+          r.samples.push_back(1e9*time(f, reps)/(reps*nops));
+        r.nsPerOp = median(r.samples);
+
+        // read counters in a separate run, so that timings are not
+        // affected by reading them
+        if (perf && !perf->events().empty()) {
+          perf->start();
+          for (long i=0; i<reps; ++i) f();
+          std::vector<double> counts = perf->stop();
+          for (std::size_t e=0; e<counts.size(); ++e)
+            r.counters.push_back(std::make_pair(perf->events()[e].name, counts[e]/(reps*nops)));
+        }
+        results.push_back(r);
+      }
+
+      /* Computes overhead ratios and writes results as a table on
+       * stdout and as JSON, if requested. Returns exit code */
+      int finish() {
+        for (Result& r : results) {
+          r.ratio = 0;
+          if (r.base.empty()) continue;
+          for (const Result& p : results)
+            if (p.name == r.name && p.type == r.base && p.nsPerOp > 0)
+              r.ratio = r.nsPerOp/p.nsPerOp;
+        }
+        if (opts.json != "-") printTable(stdout);
+        if (!opts.json.empty()) {
+          FILE *fp = opts.json == "-" ? stdout : std::fopen(opts.json.c_str(), "w");
+          if (!fp) {
+            std::fprintf(stderr, "Unable to open %s\n", opts.json.c_str());
+            return 1;
+          }
+          writeJson(fp);
+          if (fp != stdout) std::fclose(fp);
+        }
+        return 0;
+      }
+
+    private:
+      std::string name; /* Name of suite */
+      Options opts; /* Options */
+      std::vector<Result> results; /* Results of benchmarks run so far */
+      std::unique_ptr<PerfCounters> perf; /* Hardware counters, if requested */
+
+      template <typename F>
+      static double time(F& f, long reps) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (long i=0; i<reps; ++i) f();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(t1-t0).count();
+      }
+
+      void printTable(FILE *fp) const {
+        std::fprintf(fp, "%-24s %-20s %12s %8s\n", "benchmark", "type", "ns/op", "ratio");
+        for (const Result& r : results) {
+          if (r.ratio > 0)
+            std::fprintf(fp, "%-24s %-20s %12.3f %8.2f",
+              r.name.c_str(), r.type.c_str(), r.nsPerOp, r.ratio);
+          else
+            std::fprintf(fp, "%-24s %-20s %12.3f %8s",
+              r.name.c_str(), r.type.c_str(), r.nsPerOp, "-");
+          // counters per op
+          for (const auto& c : r.counters)
+            std::fprintf(fp, " %s=%.4g", c.first.c_str(), c.second);
+          std::fprintf(fp, "\n");
+        }
+      }
+
+      static std::string quote(const std::string& s) {
+        std::string q = "\"";
+        for (char c : s) {
+          if (c == '"' || c == '\\') q += '\\';
+          q += c;
+        }
+        return q + "\"";
+      }
+
+      // One result per line, keys always in the same order, so that
+      // output of different runs can be compared with text tools too
+      void writeJson(FILE *fp) const {
+        std::fprintf(fp, "{\n  \"suite\": %s,\n  \"version\": 1,\n", quote(name).c_str());
+        std::fprintf(fp, "  \"samples\": %d,\n  \"results\": [\n", opts.samples);
+        for (std::size_t i=0; i<results.size(); ++i) {
+          const Result& r = results[i];
+          std::fprintf(fp, "    {\"name\": %s, \"type\": %s, \"base\": %s, \"ns_per_op\": %.6g, \"ratio\": %.6g, \"samples\": [",
+            quote(r.name).c_str(), quote(r.type).c_str(), quote(r.base).c_str(), r.nsPerOp, r.ratio);
+          for (std::size_t s=0; s<r.samples.size(); ++s)
+            std::fprintf(fp, "%s%.6g", s>0 ? ", " : "", r.samples[s]);
+          std::fprintf(fp, "]");
+          if (!r.counters.empty()) {
+            std::fprintf(fp, ", \"counters\": {");
+            for (std::size_t c=0; c<r.counters.size(); ++c)
+              std::fprintf(fp, "%s%s: %.6g", c>0 ? ", " : "",
+                quote(r.counters[c].first).c_str(), r.counters[c].second);
+            std::fprintf(fp, "}");
+          }
+          std::fprintf(fp, "}%s\n", i+1<results.size() ? "," : "");
+        }
+        std::fprintf(fp, "  ]\n}\n");
+      }
+  };
+}
+}
@@ -0,0 +1,152 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Hardware performance counters (Linux perf_event_open) for benchmarks
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// std includes
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Gkyl {
+namespace Bench {
+
+  /* Hardware counter to read */
+  struct PerfEvent {
+      std::string name; /* Name used in output */
+      uint32_t type; /* perf_event_attr type (PERF_TYPE_*) */
+      uint64_t config; /* perf_event_attr config */
+  };
+
+  /* Set of hardware counters read around a piece of code. Counters
+   * that can not be opened (unsupported event, or no permission: see
+   * /proc/sys/kernel/perf_event_paranoid) are skipped. Only user-space
+   * events of the calling thread are counted. On systems other than
+   * Linux no counters are available */
+  class PerfCounters {
+    public:
+      /* Default events: cycles, instructions, L1 data cache and
+       * last-level cache read misses */
+      static std::vector<PerfEvent> defaultEvents() {
+        std::vector<PerfEvent> ev;
+#if defined(__linux__)
+        ev.push_back(PerfEvent { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES });
+        ev.push_back(PerfEvent { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS });
+        ev.push_back(PerfEvent { "l1d_misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D) });
+        ev.push_back(PerfEvent { "llc_misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_LL) });
+#endif
+        return ev;
+      }
+
+      /* Parses a raw event spec, name=0xCODE, where CODE is the
+       * model-specific event code (umask<<8 | event). For example,
+       * on recent Intel cores fp_256d=0x10c7 counts retired 256-bit
+       * packed double instructions (FP_ARITH_INST_RETIRED), which
+       * shows whether HyperReal code is vectorized */
+      static bool parseRaw(const std::string& spec, PerfEvent& ev) {
+        std::size_t eq = spec.find('=');
+        if (eq == std::string::npos || eq == 0) return false;
+        char *end = 0;
+        const char *code = spec.c_str()+eq+1;
+        uint64_t config = std::strtoull(code, &end, 0);
+        if (end == code || *end != '\0') return false;
+#if defined(__linux__)
+        ev = PerfEvent { spec.substr(0, eq), PERF_TYPE_RAW, config };
+#else
+        ev = PerfEvent { spec.substr(0, eq), 0, config };
+#endif
+        return true;
+      }
+
+      PerfCounters(const std::vector<PerfEvent>& events) {
+        for (const PerfEvent& e : events) {
+          int fd = open(e);
+          if (fd >= 0) {
+            fds.push_back(fd);
+            evs.push_back(e);
+          }
+          else
+            std::fprintf(stderr, "Unable to open counter %s (%s)\n", e.name.c_str(), std::strerror(errno));
+        }
+      }
+
+      ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd : fds) close(fd);
+#endif
+      }
+
+      PerfCounters(const PerfCounters&) = delete;
+      PerfCounters& operator=(const PerfCounters&) = delete;
+
+      /* Events that could be opened */
+      const std::vector<PerfEvent>& events() const { return evs; }
+
+      /* Reset and start counting */
+      void start() {
+#if defined(__linux__)
+        for (int fd : fds) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        for (int fd : fds) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+      }
+
+      /* Stop counting and return counts of each event, scaled to
+       * account for multiplexing of counters */
+      std::vector<double> stop() {
+        std::vector<double> counts;
+#if defined(__linux__)
+        for (int fd : fds) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (int fd : fds) {
+          uint64_t v[3] = { 0, 0, 0 }; // value, time enabled, time running
+          double c = 0;
+          if (::read(fd, v, sizeof(v)) == sizeof(v) && v[2] > 0)
+            c = double(v[0])*double(v[1])/double(v[2]);
+          counts.push_back(c);
+        }
+#endif
+        return counts;
+      }
+
+    private:
+      std::vector<int> fds; /* File descriptors of opened counters */
+      std::vector<PerfEvent> evs; /* Opened events */
+
+#if defined(__linux__)
+      static uint64_t cacheConfig(uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      }
+
+      static int open(const PerfEvent& e) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = e.type;
+        attr.config = e.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      }
+#else
+      static int open(const PerfEvent& e) { errno = ENOSYS; return -1; }
+#endif
+  };
+}
+}
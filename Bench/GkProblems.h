@@ -0,0 +1,112 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Standard test problems with known derivative structure, shared by
+// the benchmarks and the unit tests
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <cmath>
+#include <vector>
+
+// Each problem has eval(x,y), templated on the number type, the
+// number of outputs nout(), and a starting point x0(i)
+
+// Extended Rosenbrock function (scalar output)
+struct Rosenbrock {
+    int n = 64;
+    int nout() const { return 1; }
+
+    template <typename T>
+    void eval(const std::vector<T>& x, std::vector<T>& y) const {
+      T f = 0.0;
+      for (int i=0; i<n/2; ++i) {
+        T t1 = x[2*i+1]-x[2*i]*x[2*i], t2 = 1-x[2*i];
+        f += 100*t1*t1 + t2*t2;
+      }
+      y[0] = f;
+    }
+    double x0(int i) const { return i%2 == 0 ? -1.2 : 1.0; }
+};
+
+// Broyden tridiagonal function (MINPACK test problem 30)
+struct BroydenTridiagonal {
+    int n = 64;
+    int nout() const { return n; }
+
+    template <typename T>
+    void eval(const std::vector<T>& x, std::vector<T>& y) const {
+      for (int i=0; i<n; ++i) {
+        T xm = i>0 ? x[i-1] : T(0.0), xp = i<n-1 ? x[i+1] : T(0.0);
+        y[i] = (3-2*x[i])*x[i] - xm - 2*xp + 1;
+      }
+    }
+    double x0(int i) const { return -1.0; }
+};
+
+// Discrete boundary value function (MINPACK test problem 28)
+struct DiscreteBoundaryValue {
+    int n = 64;
+    int nout() const { return n; }
+
+    template <typename T>
+    void eval(const std::vector<T>& x, std::vector<T>& y) const {
+      double h = 1.0/(n+1);
+      for (int i=0; i<n; ++i) {
+        double t = (i+1)*h;
+        T xm = i>0 ? x[i-1] : T(0.0), xp = i<n-1 ? x[i+1] : T(0.0);
+        T c = x[i]+t+1;
+        y[i] = 2*x[i] - xm - xp + 0.5*h*h*c*c*c;
+      }
+    }
+    double x0(int i) const { double t = (i+1.0)/(n+1); return t*(t-1); }
+};
+
+// Residual of the 2-D Bratu problem, -lap(u) - lambda exp(u) = 0 on
+// the unit square, discretized with the 5-point stencil
+struct Bratu2D {
+    int nx = 16;
+    double lambda = 6.0;
+    int nin() const { return nx*nx; }
+    int nout() const { return nx*nx; }
+
+    template <typename T>
+    void eval(const std::vector<T>& u, std::vector<T>& r) const {
+      double h = 1.0/(nx+1), rh2 = 1/(h*h);
+      auto at = [&](int i, int j) { return i<0 || j<0 || i>=nx || j>=nx ? T(0.0) : u[i*nx+j]; };
+      for (int i=0; i<nx; ++i)
+        for (int j=0; j<nx; ++j) {
+          T uc = u[i*nx+j];
+          r[i*nx+j] = (4*uc - at(i-1,j) - at(i+1,j) - at(i,j-1) - at(i,j+1))*rh2
+            - lambda*Gkyl::exp(uc);
+        }
+    }
+    double x0(int k) const { int i = k/nx, j = k%nx; return 0.1*std::sin(0.3*i)*std::cos(0.2*j); }
+};
+
+// Lorenz-96 right-hand side
+struct Lorenz96 {
+    int n = 40;
+    double forcing = 8.0;
+    int nout() const { return n; }
+
+    template <typename T>
+    void eval(const std::vector<T>& x, std::vector<T>& f) const {
+      for (int i=0; i<n; ++i) {
+        const T& xm2 = x[(i-2+n)%n], &xm1 = x[(i-1+n)%n], &xp1 = x[(i+1)%n];
+        f[i] = (xp1-xm2)*xm1 - x[i] + forcing;
+      }
+    }
+    double x0(int i) const { return 8.0 + (i == 0 ? 0.01 : 0.0); }
+};
+
+// number of inputs of a problem
+template <typename P> int nin(const P& p) { return p.n; }
+inline int nin(const Bratu2D& p) { return p.nin(); }
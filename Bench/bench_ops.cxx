@@ -0,0 +1,152 @@
+// Micro-benchmarks of each HyperReal operator and math function. Each
+// is timed on arrays of inputs, for primal and HyperReal numbers, and
+// the ratio of HyperReal to primal time is reported. Complex-step
+// numbers are timed too, for comparison with HyperDouble.
+
+#include <GkForwardAutoDiff.h>
+#include <GkComplexStep.h>
+#include <GkDynLanes.h>
+#include <GkBench.h>
+#include <vector>
+
+// number of elements in input/output arrays
+static const int M = 1024;
+
+// Make inputs: real part v, and unit tangent in a lane chosen by i
+template <typename T>
+struct Seed {
+    static T make(double v, int i) { return T(v); }
+};
+template <typename RT, typename AT>
+struct Seed<Gkyl::HyperReal<RT,AT> > {
+    static Gkyl::HyperReal<RT,AT> make(double v, int i) { return Gkyl::HyperReal<RT,AT>(v, 1); }
+};
+template <typename T>
+struct Seed<Gkyl::ComplexStep<T> > {
+    static Gkyl::ComplexStep<T> make(double v, int i) { return Gkyl::ComplexStep<T>(v, 1); }
+};
+template <typename RT, typename T, int N, int A>
+struct Seed<Gkyl::HyperReal<RT,Gkyl::Lanes<T,N,A> > > {
+    static Gkyl::HyperReal<RT,Gkyl::Lanes<T,N,A> > make(double v, int i) {
+      Gkyl::Lanes<T,N,A> t(0);
+      t[i%N] = 1;
+      return Gkyl::HyperReal<RT,Gkyl::Lanes<T,N,A> >(v, t);
+    }
+};
+
+template <typename RT, typename T, int K>
+struct Seed<Gkyl::HyperReal<RT,Gkyl::DynLanes<T,K> > > {
+    static Gkyl::HyperReal<RT,Gkyl::DynLanes<T,K> > make(double v, int i) {
+      return Gkyl::HyperReal<RT,Gkyl::DynLanes<T,K> >(v, Gkyl::DynLanes<T,K>::unit(K, i%K));
+    }
+};
+
+// Real type of number type T: passive constants have this type, so
+// that they do not promote float arithmetic to double
+template <typename T>
+struct Real { typedef T type; };
+template <typename RT, typename AT>
+struct Real<Gkyl::HyperReal<RT,AT> > { typedef RT type; };
+template <typename T>
+struct Real<Gkyl::ComplexStep<T> > { typedef T type; };
+
+// Runs all benchmarks for number type T. 'base' is the name of the
+// primal type to compare to (empty if T is primal)
+template <typename T>
+void
+benchType(Gkyl::Bench::Suite& suite, const std::string& type, const std::string& base) {
+  std::vector<T> x(M), y(M), z(M);
+  for (int i=0; i<M; ++i) {
+    // inputs in (0.1,0.9) are in the domain of all functions
+    x[i] = Seed<T>::make(0.1+0.8*i/M, i);
+    y[i] = Seed<T>::make(0.9-0.8*i/M, i+1);
+  }
+  typedef typename Real<T>::type R;
+  const R c = R(0.75);
+  volatile int nv = 5;
+  const int n = nv; // not known at compile time
+
+  // Times loop of z[i] = EXPR over all elements
+  auto run = [&](const char *name, auto op) {
+    suite.run(name, type, base, M, [&]() {
+        for (int i=0; i<M; ++i) z[i] = op(x[i], y[i]);
+        Gkyl::Bench::keep(z[0]);
+      }
+    );
+  };
+
+  // operators
+  run("add", [](const T& a, const T& b) { return a+b; });
+  run("sub", [](const T& a, const T& b) { return a-b; });
+  run("mul", [](const T& a, const T& b) { return a*b; });
+  run("div", [](const T& a, const T& b) { return a/b; });
+  run("neg", [](T a, const T& b) { return -a; });
+  run("pos", [](T a, const T& b) { return +a; });
+  // passive scalar on the right (op_scalar) and on the left (scalar_op)
+  run("add_scalar", [=](const T& a, const T& b) { return a+c; });
+  run("scalar_add", [=](const T& a, const T& b) { return c+a; });
+  run("sub_scalar", [=](const T& a, const T& b) { return a-c; });
+  run("scalar_sub", [=](const T& a, const T& b) { return c-a; });
+  run("mul_scalar", [=](const T& a, const T& b) { return a*c; });
+  run("scalar_mul", [=](const T& a, const T& b) { return c*a; });
+  run("div_scalar", [=](const T& a, const T& b) { return a/c; });
+  run("scalar_div", [=](const T& a, const T& b) { return c/a; });
+  // assignment
+  run("assign", [](const T& a, const T& b) { T r; r = a; return r; });
+  run("assign_scalar", [=](const T& a, const T& b) { T r; r = c; return r; });
+  run("add_assign", [](T a, const T& b) { a += b; return a; });
+  run("sub_assign", [](T a, const T& b) { a -= b; return a; });
+  run("mul_assign", [](T a, const T& b) { a *= b; return a; });
+  run("div_assign", [](T a, const T& b) { a /= b; return a; });
+  // comparisons, each selecting one of the operands
+  run("lt", [](const T& a, const T& b) { return a < b ? a : b; });
+  run("gt", [](const T& a, const T& b) { return a > b ? a : b; });
+  run("le", [](const T& a, const T& b) { return a <= b ? a : b; });
+  run("ge", [](const T& a, const T& b) { return a >= b ? a : b; });
+  run("eq", [](const T& a, const T& b) { return a == b ? a : b; });
+  run("ne", [](const T& a, const T& b) { return a != b ? a : b; });
+
+  // math functions
+  run("sqrt", [](const T& a, const T& b) { return Gkyl::sqrt(a); });
+  run("cos", [](const T& a, const T& b) { return Gkyl::cos(a); });
+  run("sin", [](const T& a, const T& b) { return Gkyl::sin(a); });
+  run("tan", [](const T& a, const T& b) { return Gkyl::tan(a); });
+  run("asin", [](const T& a, const T& b) { return Gkyl::asin(a); });
+  run("acos", [](const T& a, const T& b) { return Gkyl::acos(a); });
+  run("atan", [](const T& a, const T& b) { return Gkyl::atan(a); });
+  run("sinh", [](const T& a, const T& b) { return Gkyl::sinh(a); });
+  run("cosh", [](const T& a, const T& b) { return Gkyl::cosh(a); });
+  run("tanh", [](const T& a, const T& b) { return Gkyl::tanh(a); });
+  run("exp", [](const T& a, const T& b) { return Gkyl::exp(a); });
+  run("log", [](const T& a, const T& b) { return Gkyl::log(a); });
+  run("abs", [](const T& a, const T& b) { return Gkyl::abs(a); });
+  run("floor", [](const T& a, const T& b) { return Gkyl::floor(a); });
+  run("ceil", [](const T& a, const T& b) { return Gkyl::ceil(a); });
+  run("cbrt", [](const T& a, const T& b) { return Gkyl::cbrt(a); });
+  run("pow_int", [=](const T& a, const T& b) { return Gkyl::pow(a, n); });
+  run("pow_5", [](const T& a, const T& b) { return Gkyl::pow<5>(a); });
+  run("pow_real", [=](const T& a, const T& b) { return Gkyl::pow(a, c); });
+  run("pow", [](const T& a, const T& b) { return Gkyl::pow(a, b); });
+  run("hypot", [](const T& a, const T& b) { return Gkyl::hypot(a, b); });
+  run("atan2", [](const T& a, const T& b) { return Gkyl::atan2(a, b); });
+}
+
+int
+main(int argc, char **argv) {
+  Gkyl::Bench::Suite suite("ops", argc, argv);
+
+  benchType<double>(suite, "double", "");
+  benchType<float>(suite, "float", "");
+  benchType<Gkyl::HyperDouble>(suite, "HyperDouble", "double");
+  benchType<Gkyl::HyperFloat>(suite, "HyperFloat", "float");
+  benchType<Gkyl::HyperReal<double, Gkyl::Lanes<double,4> > >(suite, "HyperDouble<4>", "double");
+  benchType<Gkyl::HyperReal<double, Gkyl::AlignedLanes<double,4> > >(suite, "HyperDoubleA<4>", "double");
+  benchType<Gkyl::HyperReal<float, Gkyl::Lanes<float,8> > >(suite, "HyperFloat<8>", "float");
+  benchType<Gkyl::HyperDoubleF>(suite, "HyperDoubleF", "double");
+  benchType<Gkyl::HyperReal<double, Gkyl::Lanes<float,8> > >(suite, "HyperDoubleF<8>", "double");
+  benchType<Gkyl::HyperReal<double, Gkyl::Lanes<Gkyl::BFloat16,8> > >(suite, "HyperDoubleBF<8>", "double");
+  benchType<Gkyl::HyperReal<double, Gkyl::DynLanes<double> > >(suite, "HyperDoubleDyn<8>", "double");
+  benchType<Gkyl::ComplexStepDouble>(suite, "ComplexStepDouble", "double");
+
+  return suite.finish();
+}
@@ -0,0 +1,187 @@
+// Benchmarks of derivatives of standard test problems: extended
+// Rosenbrock gradient, MINPACK-style Jacobians, a 2-D Poisson (Bratu)
+// residual and an ODE right-hand side (Lorenz-96). Each problem is run
+// in primal mode and the full derivative is computed in each AD mode,
+// and the ratio of the AD time to the primal time is reported.
+
+#include <GkForwardAutoDiff.h>
+#include <GkReverseAutoDiff.h>
+#include <GkComplexStep.h>
+#include <GkBlockLanes.h>
+#include <GkDynLanes.h>
+#include <GkSparseTangent.h>
+#include <GkBench.h>
+#include <GkProblems.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// width of vector-forward mode tangents
+static const int W = 8;
+// width of block-forward mode tangents, which only compute the lanes
+// each quantity depends on
+static const int BW = 64;
+
+// Primal evaluation
+template <typename P>
+void
+primal(const P& p, std::vector<double>& x, std::vector<double>& y) {
+  p.eval(x, y);
+  Gkyl::Bench::keep(y[0]);
+}
+
+// Jacobian (row-major, nout x nin) using one forward sweep per input,
+// with HyperDouble or ComplexStepDouble numbers FT
+template <typename P, typename FT>
+void
+forward(const P& p, std::vector<FT>& x, std::vector<FT>& y, std::vector<double>& J) {
+  int n = nin(p), m = p.nout();
+  for (int j=0; j<n; ++j) {
+    x[j] = FT(x[j].real(), 1.0);
+    p.eval(x, y);
+    x[j] = FT(x[j].real(), 0.0);
+    for (int i=0; i<m; ++i) J[i*n+j] = y[i].inf();
+  }
+  Gkyl::Bench::keep(J[0]);
+}
+
+// Jacobian using one recording and one reverse sweep per output. The
+// tape is rewound after each evaluation, so its memory is reused
+template <typename P>
+void
+reverse(const P& p, std::vector<Gkyl::ReverseDouble>& x, std::vector<Gkyl::ReverseDouble>& y,
+  std::vector<double>& J) {
+  int n = nin(p), m = p.nout();
+  for (int j=0; j<n; ++j) x[j] = Gkyl::ReverseDouble::input(x[j].real());
+  p.eval(x, y);
+  for (int i=0; i<m; ++i) {
+    y[i].gradient();
+    for (int j=0; j<n; ++j) J[i*n+j] = x[j].adjoint();
+  }
+  Gkyl::Tape<double>::get().rewind();
+  Gkyl::Bench::keep(J[0]);
+}
+
+// Jacobian using one forward sweep per LT::width inputs, with tangents
+// of type LT (Lanes or BlockLanes)
+template <typename P, typename LT>
+void
+vectorForward(const P& p, std::vector<Gkyl::HyperReal<double,LT> >& x,
+  std::vector<Gkyl::HyperReal<double,LT> >& y, std::vector<double>& J) {
+  typedef Gkyl::HyperReal<double,LT> VT;
+  const int w = LT::width;
+  int n = nin(p), m = p.nout();
+  for (int j0=0; j0<n; j0+=w) {
+    int nj = std::min(w, n-j0);
+    for (int k=0; k<nj; ++k) {
+      LT seed(0.0);
+      seed[k] = 1.0;
+      x[j0+k] = VT(x[j0+k].real(), seed);
+    }
+    p.eval(x, y);
+    for (int k=0; k<nj; ++k) x[j0+k] = VT(x[j0+k].real(), 0.0);
+    for (int i=0; i<m; ++i) {
+      const LT t = y[i].inf();
+      for (int k=0; k<nj; ++k) J[i*n+j0+k] = t[k];
+    }
+  }
+  Gkyl::Bench::keep(J[0]);
+}
+
+// Jacobian using one forward sweep per w inputs, with the width w
+// only known at run time
+template <typename P>
+void
+dynamicForward(const P& p, int w, std::vector<Gkyl::HyperReal<double, Gkyl::DynLanes<double> > >& x,
+  std::vector<Gkyl::HyperReal<double, Gkyl::DynLanes<double> > >& y, std::vector<double>& J) {
+  typedef Gkyl::DynLanes<double> DL;
+  typedef Gkyl::HyperReal<double,DL> DT;
+  int n = nin(p), m = p.nout();
+  for (int j0=0; j0<n; j0+=w) {
+    int nj = std::min(w, n-j0);
+    for (int k=0; k<nj; ++k) x[j0+k] = DT(x[j0+k].real(), DL::unit(w, k));
+    p.eval(x, y);
+    for (int k=0; k<nj; ++k) x[j0+k] = DT(x[j0+k].real());
+    for (int i=0; i<m; ++i) {
+      const DL t = y[i].inf();
+      for (int k=0; k<nj; ++k) J[i*n+j0+k] = t[k];
+    }
+  }
+  Gkyl::Bench::keep(J[0]);
+}
+
+// Jacobian in one forward sweep with sparse tangents: each output
+// only carries the inputs it depends on
+template <typename P>
+void
+sparseForward(const P& p, std::vector<Gkyl::HyperReal<double, Gkyl::SparseTangent<double> > >& x,
+  std::vector<Gkyl::HyperReal<double, Gkyl::SparseTangent<double> > >& y, std::vector<double>& J) {
+  typedef Gkyl::SparseTangent<double> ST;
+  typedef Gkyl::HyperReal<double,ST> XT;
+  int n = nin(p), m = p.nout();
+  for (int j=0; j<n; ++j) x[j] = XT(x[j].real(), ST::unit(j));
+  p.eval(x, y);
+  std::fill(J.begin(), J.end(), 0.0);
+  for (int i=0; i<m; ++i) {
+    const ST& t = y[i].inf();
+    for (int k=0; k<t.nnz(); ++k) J[i*n+t.index(k)] = t.value(k);
+  }
+  Gkyl::Bench::keep(J[0]);
+}
+
+// Runs problem in all modes
+template <typename P>
+void
+benchProblem(Gkyl::Bench::Suite& suite, const char *name, const P& p) {
+  typedef Gkyl::HyperReal<double, Gkyl::Lanes<double,W> > VT;
+  typedef Gkyl::HyperReal<double, Gkyl::AlignedLanes<double,W> > AT;
+  typedef Gkyl::HyperReal<double, Gkyl::BlockLanes<double,BW> > BT;
+  typedef Gkyl::HyperReal<double, Gkyl::SparseTangent<double> > ST;
+  typedef Gkyl::HyperReal<double, Gkyl::DynLanes<double> > DT;
+  int n = nin(p), m = p.nout();
+
+  std::vector<double> x(n), y(m), J(m*n);
+  std::vector<Gkyl::HyperDouble> hx(n), hy(m);
+  std::vector<VT> vx(n), vy(m);
+  std::vector<AT> ax(n), ay(m);
+  std::vector<BT> bx(n), by(m);
+  std::vector<ST> sx(n), sy(m);
+  std::vector<DT> dx(n), dy(m);
+  std::vector<Gkyl::ComplexStepDouble> cx(n), cy(m);
+  std::vector<Gkyl::ReverseDouble> rx(n), ry(m);
+  for (int i=0; i<n; ++i) {
+    x[i] = p.x0(i);
+    hx[i] = Gkyl::HyperDouble(x[i]);
+    vx[i] = VT(x[i]);
+    ax[i] = AT(x[i]);
+    bx[i] = BT(x[i]);
+    sx[i] = ST(x[i]);
+    dx[i] = DT(x[i]);
+    cx[i] = Gkyl::ComplexStepDouble(x[i]);
+    rx[i] = Gkyl::ReverseDouble(x[i]);
+  }
+
+  suite.run(name, "primal", "", 1, [&]() { primal(p, x, y); });
+  suite.run(name, "forward", "primal", 1, [&]() { forward(p, hx, hy, J); });
+  suite.run(name, "vector-forward", "primal", 1, [&]() { vectorForward(p, vx, vy, J); });
+  suite.run(name, "aligned-forward", "primal", 1, [&]() { vectorForward(p, ax, ay, J); });
+  volatile int w = W; // not known at compile time
+  suite.run(name, "dynamic-forward", "primal", 1, [&]() { dynamicForward(p, w, dx, dy, J); });
+  suite.run(name, "block-forward", "primal", 1, [&]() { vectorForward(p, bx, by, J); });
+  suite.run(name, "sparse-forward", "primal", 1, [&]() { sparseForward(p, sx, sy, J); });
+  suite.run(name, "complex-step", "primal", 1, [&]() { forward(p, cx, cy, J); });
+  suite.run(name, "reverse", "primal", 1, [&]() { reverse(p, rx, ry, J); });
+}
+
+int
+main(int argc, char **argv) {
+  Gkyl::Bench::Suite suite("problems", argc, argv);
+
+  benchProblem(suite, "rosenbrock", Rosenbrock());
+  benchProblem(suite, "broyden_tridiagonal", BroydenTridiagonal());
+  benchProblem(suite, "discrete_bvp", DiscreteBoundaryValue());
+  benchProblem(suite, "bratu2d", Bratu2D());
+  benchProblem(suite, "lorenz96", Lorenz96());
+
+  return suite.finish();
+}
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# -*- python -*-
+#
+# Performance regression gate for the benchmarks in this directory.
+#
+# Record a baseline by running benchmark programs:
+#
+#   ./Bench/perfgate.py record -o baseline.json build/Bench/bench_ops build/Bench/bench_problems
+#
+# Later, run the same programs and compare to the baseline:
+#
+#   ./Bench/perfgate.py check -b baseline.json build/Bench/bench_ops build/Bench/bench_problems
+#
+# or compare result files written with --json by the programs:
+#
+#   ./Bench/perfgate.py compare baseline.json new.json
+#
+# Each benchmark is summarized by the median of its samples, and a
+# bootstrap confidence interval of the ratio of new to baseline medians
+# is computed. The check fails (exit code 1) if, for any AD benchmark,
+# the lower end of this interval is above 1+threshold, i.e. when the
+# slowdown is larger than the threshold with the given confidence.
+
+import argparse
+import json
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+
+def median(v):
+    s = sorted(v)
+    n = len(s)
+    if n == 0:
+        return 0.0
+    return s[n//2] if n%2 == 1 else 0.5*(s[n//2-1]+s[n//2])
+
+
+def bootstrapInterval(stat, sampleSets, confidence, nboot, rng):
+    """Bootstrap percentile interval of stat(*resampled sets)"""
+    vals = []
+    for _ in range(nboot):
+        rs = [[rng.choice(s) for _ in s] for s in sampleSets]
+        vals.append(stat(*rs))
+    vals.sort()
+    lo = vals[int((1-confidence)/2*(nboot-1))]
+    hi = vals[int((1+confidence)/2*(nboot-1))]
+    return lo, hi
+
+
+def indexResults(d):
+    """Indexes JSON results by (suite, name, type). d is the output of
+    one program, or a set of them stored by this script"""
+    res = {}
+    suites = d["suites"] if "suites" in d else [d]
+    for s in suites:
+        for r in s["results"]:
+            res[(s["suite"], r["name"], r["type"])] = r
+    return res
+
+
+def loadResults(fileName):
+    with open(fileName) as f:
+        return indexResults(json.load(f))
+
+
+def runPrograms(programs, samples, extraArgs):
+    """Runs benchmark programs, returning their JSON results"""
+    suites = []
+    for prog in programs:
+        with tempfile.TemporaryDirectory() as tmp:
+            out = os.path.join(tmp, "res.json")
+            cmd = [prog, "--samples", str(samples), "--json", out] + extraArgs
+            print("Running %s" % " ".join(cmd), file=sys.stderr)
+            subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+            with open(out) as f:
+                suites.append(json.load(f))
+    return {"suites": suites}
+
+
+def compare(base, new, args):
+    """Compares new results to baseline, returning number of regressions"""
+    rng = random.Random(args.seed)
+    nregress = 0
+    print("%-12s %-24s %-20s %10s %10s %8s %17s" %
+          ("suite", "benchmark", "type", "base", "new", "change", "interval"))
+    for key in sorted(new.keys()):
+        if key not in base:
+            continue
+        b, n = base[key], new[key]
+        if args.metric == "ratio":
+            # compare overhead relative to primal benchmark of same run
+            if not n["base"]:
+                continue
+            bprim, nprim = base.get((key[0], key[1], b["base"])), new.get((key[0], key[1], n["base"]))
+            if bprim is None or nprim is None:
+                continue
+            stat = lambda bs, bps, ns, nps: (median(ns)/median(nps))/(median(bs)/median(bps))
+            sets = [b["samples"], bprim["samples"], n["samples"], nprim["samples"]]
+            bval, nval = median(b["samples"])/median(bprim["samples"]), median(n["samples"])/median(nprim["samples"])
+        else:
+            stat = lambda bs, ns: median(ns)/median(bs)
+            sets = [b["samples"], n["samples"]]
+            bval, nval = median(b["samples"]), median(n["samples"])
+        if bval <= 0:
+            continue
+        lo, hi = bootstrapInterval(stat, sets, args.confidence, args.nboot, rng)
+        change = nval/bval
+        # only AD benchmarks (those with a primal to compare to) gate
+        regress = bool(n["base"]) and lo > 1+args.threshold
+        nregress += regress
+        print("%-12s %-24s %-20s %10.4g %10.4g %7.1f%% [%6.3f, %6.3f]%s" %
+              (key[0], key[1], key[2], bval, nval, 100*(change-1), lo, hi,
+               "  REGRESSION" if regress else ""))
+    return nregress
+
+
+def main():
+    p = argparse.ArgumentParser(description="Benchmark regression gate")
+    sub = p.add_subparsers(dest="cmd", required=True)
+
+    pr = sub.add_parser("record", help="run benchmarks and store a baseline")
+    pr.add_argument("-o", "--output", required=True, help="baseline file to write")
+
+    pc = sub.add_parser("check", help="run benchmarks and compare to a baseline")
+    pc.add_argument("-b", "--baseline", required=True, help="baseline file")
+    pc.add_argument("-o", "--output", help="also store results of this run here")
+
+    pm = sub.add_parser("compare", help="compare two result files")
+    pm.add_argument("baseline", help="baseline result file")
+    pm.add_argument("new", help="new result file")
+
+    for s in (pr, pc):
+        s.add_argument("programs", nargs="+", help="benchmark programs to run")
+        s.add_argument("--samples", type=int, default=11, help="samples per benchmark")
+        s.add_argument("--filter", help="only run benchmarks containing this")
+    for s in (pc, pm):
+        s.add_argument("--threshold", type=float, default=0.05,
+                       help="allowed slowdown, as a fraction (default 0.05)")
+        s.add_argument("--confidence", type=float, default=0.95,
+                       help="confidence level of interval (default 0.95)")
+        s.add_argument("--metric", choices=["time", "ratio"], default="time",
+                       help="compare ns/op, or the ratio to primal ns/op of the same run")
+        s.add_argument("--nboot", type=int, default=2000, help="bootstrap resamples")
+        s.add_argument("--seed", type=int, default=1, help="random seed of bootstrap")
+    args = p.parse_args()
+
+    extra = ["--filter", args.filter] if getattr(args, "filter", None) else []
+    if args.cmd == "record":
+        res = runPrograms(args.programs, args.samples, extra)
+        with open(args.output, "w") as f:
+            json.dump(res, f, indent=1, sort_keys=True)
+        return 0
+
+    if args.cmd == "check":
+        res = runPrograms(args.programs, args.samples, extra)
+        if args.output:
+            with open(args.output, "w") as f:
+                json.dump(res, f, indent=1, sort_keys=True)
+        base, new = loadResults(args.baseline), indexResults(res)
+    else:
+        base, new = loadResults(args.baseline), loadResults(args.new)
+
+    nregress = compare(base, new, args)
+    if nregress > 0:
+        print("%d benchmark(s) regressed by more than %g%%" % (nregress, 100*args.threshold))
+        return 1
+    print("No regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
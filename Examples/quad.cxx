@@ -1,4 +1,6 @@
 #include <GkForwardAutoDiff.h>
+#include <GkQuadrature.h>
+#include <GkOpCounter.h>
 #include <iostream>
 #include <cmath>
 
@@ -21,12 +23,26 @@ T
 quad(T x, T a, T b) {
   T sum(0.0);
   for (int i=0; i<3; ++i) {
-    T eta = gkyl_gauss_ordinates_3[i];
+    T eta(gkyl_gauss_ordinates_3[i]);
     sum += gkyl_gauss_weights_3[i]*Gfunc(x, a + 0.5*(b-a)*(1+eta));
   }
   return 0.5*(b-a)*sum;
 }
 
+// Same as quad, but Gfunc is evaluated at all nodes in a single call
+template <typename T>
+T
+quadPacked(T x, T a, T b) {
+  Gkyl::Packed<T,3> px = Gkyl::pack<3>(x);
+  return Gkyl::quadPacked<3>([&](const Gkyl::Packed<T,3>& y) { return Gfunc(px, y); }, a, b);
+}
+
+// Same as quad, but dF(x)/dx is computed using the Leibniz rule
+Gkyl::HyperDouble
+quadLeibniz(Gkyl::HyperDouble x, Gkyl::HyperDouble a, Gkyl::HyperDouble b) {
+  return Gkyl::quadLeibniz<3>([](const auto& x, const auto& y) { return Gfunc(x, y); }, x, a, b);
+}
+
 int main(void) {
 
   do {
@@ -44,6 +60,34 @@ int main(void) {
     std::cout << "(real) quad " << res << std::endl;
 
   } while (0);  
+
+  do {
+    Gkyl::HyperDouble x(1.0, 1.0);
+    Gkyl::HyperDouble res = quadPacked(x, x, 2*x*x+x);
+    std::cout << "(packed) quad " << res.real() << " diff " << res.inf() << std::endl;
+  } while (0);
+
+  do {
+    Gkyl::HyperDouble x(1.0, 1.0);
+    Gkyl::HyperDouble res = quadLeibniz(x, x, 2*x*x+x);
+    std::cout << "(Leibniz) quad " << res.real() << " diff " << res.inf() << std::endl;
+  } while (0);
+
+  do {
+    // count operations needed by quad in primal and AD mode
+    typedef Gkyl::Counted<double> CDouble;
+    do {
+      Gkyl::OpCountScope scope("quad (primal)");
+      CDouble x = 1.0;
+      quad(x, x, 2*x*x+x);
+    } while (0);
+    do {
+      Gkyl::OpCountScope scope("quad (HyperReal)");
+      Gkyl::HyperReal<CDouble> x(1.0, 1.0);
+      quad(x, x, 2*x*x+x);
+    } while (0);
+    Gkyl::OpCounter::report(std::cout);
+  } while (0);
     
   return 0;
 }
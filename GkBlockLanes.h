@@ -0,0 +1,155 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Vector tangents that skip structurally zero lanes
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <algorithm>
+
+namespace Gkyl {
+
+  /* Fixed-width pack of N numbers, like Lanes, of which only the
+   * contiguous range [lo,hi) can be nonzero. Lanes outside the range
+   * are not stored or computed, so with block seeding (one lane per
+   * input of a block of inputs) a quantity that depends on only a few
+   * of the inputs costs only those lanes. The range grows as needed:
+   * the sum of numbers with ranges [a,b) and [c,d) has range
+   * [min(a,c),max(b,d)). Use as the infinitesimal part of a
+   * HyperReal, HyperReal<double,BlockLanes<double,N>> */
+  template <typename T, int N>
+  class BlockLanes {
+    public:
+      // number of lanes
+      static const int width = N;
+
+      // various ctors. Zero has an empty range
+      BlockLanes() : l(0), u(0) { }
+      BlockLanes(const T& s) : l(0), u(0) {
+        if (s != T(0)) {
+          u = N;
+          for (int i=0; i<N; ++i) v[i] = s;
+        }
+      }
+
+      // copies only move the lanes in range
+      BlockLanes(const BlockLanes& x) : l(x.l), u(x.u) {
+        for (int i=l; i<u; ++i) v[i] = x.v[i];
+      }
+      BlockLanes& operator=(const BlockLanes& x) {
+        l = x.l; u = x.u;
+        for (int i=l; i<u; ++i) v[i] = x.v[i];
+        return *this;
+      }
+
+      // s in lane i, zero in all others
+      static BlockLanes unit(int i, const T& s = T(1)) {
+        BlockLanes r;
+        r.l = i; r.u = i+1; r.v[i] = s;
+        return r;
+      }
+
+      // lanes lo to hi-1 from numbers stored contiguously
+      static BlockLanes load(const T *p, int lo, int hi) {
+        BlockLanes r;
+        r.l = lo; r.u = hi;
+        for (int i=lo; i<hi; ++i) r.v[i] = p[i-lo];
+        return r;
+      }
+
+      // range of lanes that can be nonzero
+      int lo() const { return l; }
+      int hi() const { return u; }
+      // true if all lanes are zero
+      bool empty() const { return l == u; }
+
+      // access to individual lanes. The non-const access adds the lane
+      // to the range, so read lanes through a const reference
+      T operator[](int i) const { return i >= l && i < u ? v[i] : T(0); }
+      T& operator[](int i) { widen(i, i+1); return v[i]; }
+
+      // compound assignment +=, -=, *=, /=. Only sums change the range
+      BlockLanes& operator+=(const BlockLanes& y) {
+        widen(y.l, y.u);
+        for (int i=y.l; i<y.u; ++i) v[i] += y.v[i];
+        return *this;
+      }
+      BlockLanes& operator-=(const BlockLanes& y) {
+        widen(y.l, y.u);
+        for (int i=y.l; i<y.u; ++i) v[i] -= y.v[i];
+        return *this;
+      }
+      BlockLanes& operator*=(const T& s) { for (int i=l; i<u; ++i) v[i] *= s; return *this; }
+      BlockLanes& operator/=(const T& s) { for (int i=l; i<u; ++i) v[i] /= s; return *this; }
+
+      // binary +, -
+      friend BlockLanes operator+(const BlockLanes& x, const BlockLanes& y) {
+        if (x.u-x.l < y.u-y.l) { BlockLanes r(y); return r += x; }
+        BlockLanes r(x); return r += y;
+      }
+      friend BlockLanes operator-(const BlockLanes& x, const BlockLanes& y) { BlockLanes r(x); return r -= y; }
+      // binary *, / by scalar
+      friend BlockLanes operator*(const BlockLanes& x, const T& s) { return x.scale(s); }
+      friend BlockLanes operator*(const T& s, const BlockLanes& x) { return x.scale(s); }
+      friend BlockLanes operator/(const BlockLanes& x, const T& s) { BlockLanes r(x); return r /= s; }
+
+      // unary -, +
+      BlockLanes operator-() const { return scale(T(-1)); }
+      BlockLanes operator+() const { return *this; }
+
+      // a*s+c in one pass over the lanes of a, fused in each lane. This
+      // is found by argument-dependent lookup from the HyperReal
+      // operators, in preference to the unfused generic _fma
+      friend BlockLanes _fma(const BlockLanes& a, const T& s, const BlockLanes& c) {
+        BlockLanes r(c);
+        r.widen(a.l, a.u);
+        for (int i=a.l; i<a.u; ++i) r.v[i] = _fma(a.v[i], s, r.v[i]);
+        return r;
+      }
+
+      // true if all lanes are zero: found by argument-dependent lookup
+      // where the HyperReal rules skip terms scaled by a zero tangent
+      friend bool _isZero(const BlockLanes& x) {
+        for (int i=x.l; i<x.u; ++i) if (x.v[i] != T(0)) return false;
+        return true;
+      }
+
+    private:
+      int l, u; /* Range [l,u) of lanes that can be nonzero */
+      T v[N]; /* Values in each lane, only those in range are set */
+
+      BlockLanes scale(const T& s) const {
+        BlockLanes r;
+        r.l = l; r.u = u;
+        for (int i=l; i<u; ++i) r.v[i] = v[i]*s;
+        return r;
+      }
+
+      // extend range to include [a,b), zeroing lanes that are added
+      // between the old and new ranges
+      void widen(int a, int b) {
+        if (a >= b) return;
+        if (l == u) {
+          l = a; u = b;
+          for (int i=a; i<b; ++i) v[i] = T(0);
+          return;
+        }
+        for (int i=a; i<l; ++i) v[i] = T(0);
+        for (int i=u; i<b; ++i) v[i] = T(0);
+        l = std::min(l, a); u = std::max(u, b);
+      }
+  };
+
+  namespace {
+    /* BlockLanes tangents are scaled by a scalar */
+    template <typename T, int N, typename RT>
+    struct _S<BlockLanes<T,N>, RT> { typedef typename _S<T,RT>::type type; };
+  }
+}
@@ -0,0 +1,137 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Forward-mode derivatives using the complex-step method
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <complex>
+
+namespace Gkyl {
+
+  namespace {
+    /* Size of imaginary step: small enough that h^2 terms are below
+     * round-off, large enough that h times derivatives does not
+     * underflow */
+    template <typename T> struct _cs_step { static T h() { return 1e-20; } };
+    template <> struct _cs_step<float> { static float h() { return 1e-10f; } };
+  }
+
+  /* Complex-step number: f(x+ih) = f(x) + ih f'(x) + O(h^2), so the
+   * derivative is Im(f(x+ih))/h with no subtractive cancellation. The
+   * interface is that of HyperReal: ComplexStep<double>(x, 1.0) seeds
+   * the derivative, and real() and inf() return the value and the
+   * derivative. Math functions are the Gkyl:: functions, as for
+   * HyperReal numbers, so the same templated code can be run with
+   * either type and the results compared */
+  template <typename T>
+  class ComplexStep {
+    public:
+      // various ctors
+      ComplexStep() : z(0) { }
+      ComplexStep(const T& rel) : z(rel) { }
+      ComplexStep(const T& rel, const T& inf) : z(rel, _cs_step<T>::h()*inf) { }
+
+      // make number from complex value
+      static ComplexStep fromComplex(const std::complex<T>& c) {
+        ComplexStep r;
+        r.z = c;
+        return r;
+      }
+
+      // real and infinitesimal parts of number
+      T real() const { return z.real(); }
+      T inf() const { return z.imag()/_cs_step<T>::h(); }
+      // underlying complex value
+      const std::complex<T>& value() const { return z; }
+
+      // compound assignment +=, -=, *=, /=
+      ComplexStep& operator+=(const ComplexStep& y) { z += y.z; return *this; }
+      ComplexStep& operator-=(const ComplexStep& y) { z -= y.z; return *this; }
+      ComplexStep& operator*=(const ComplexStep& y) { z *= y.z; return *this; }
+      ComplexStep& operator/=(const ComplexStep& y) { z /= y.z; return *this; }
+
+      // binary +
+      friend ComplexStep operator+(const ComplexStep& x, const ComplexStep& y) { return fromComplex(x.z+y.z); }
+      friend ComplexStep operator+(const ComplexStep& x, const T& y) { return fromComplex(x.z+y); }
+      friend ComplexStep operator+(const T& x, const ComplexStep& y) { return fromComplex(x+y.z); }
+      // binary -
+      friend ComplexStep operator-(const ComplexStep& x, const ComplexStep& y) { return fromComplex(x.z-y.z); }
+      friend ComplexStep operator-(const ComplexStep& x, const T& y) { return fromComplex(x.z-y); }
+      friend ComplexStep operator-(const T& x, const ComplexStep& y) { return fromComplex(x-y.z); }
+      // binary *
+      friend ComplexStep operator*(const ComplexStep& x, const ComplexStep& y) { return fromComplex(x.z*y.z); }
+      friend ComplexStep operator*(const ComplexStep& x, const T& y) { return fromComplex(x.z*y); }
+      friend ComplexStep operator*(const T& x, const ComplexStep& y) { return fromComplex(x*y.z); }
+      // binary /
+      friend ComplexStep operator/(const ComplexStep& x, const ComplexStep& y) { return fromComplex(x.z/y.z); }
+      friend ComplexStep operator/(const ComplexStep& x, const T& y) { return fromComplex(x.z/y); }
+      friend ComplexStep operator/(const T& x, const ComplexStep& y) { return fromComplex(x/y.z); }
+
+      // unary -, +
+      ComplexStep operator-() const { return fromComplex(-z); }
+      ComplexStep operator+() const { return *this; }
+
+      // relational and equality operators compare real parts
+      friend bool operator<(const ComplexStep& x, const ComplexStep& y) { return x.real() < y.real(); }
+      friend bool operator>(const ComplexStep& x, const ComplexStep& y) { return x.real() > y.real(); }
+      friend bool operator<=(const ComplexStep& x, const ComplexStep& y) { return x.real() <= y.real(); }
+      friend bool operator>=(const ComplexStep& x, const ComplexStep& y) { return x.real() >= y.real(); }
+      friend bool operator==(const ComplexStep& x, const ComplexStep& y) { return x.real() == y.real(); }
+      friend bool operator!=(const ComplexStep& x, const ComplexStep& y) { return x.real() != y.real(); }
+
+    private:
+      std::complex<T> z; /* Value x+ih */
+  };
+
+  // Predefined types
+  using ComplexStepDouble = ComplexStep<double>;
+
+  namespace {
+    // specialization to ComplexStep: functions of complex argument
+    template <typename T>
+    struct _m<ComplexStep<T> > {
+        typedef ComplexStep<T> CS;
+
+        static CS sqrt(const CS& x) { return CS::fromComplex(std::sqrt(x.value())); }
+        static CS cos(const CS& x) { return CS::fromComplex(std::cos(x.value())); }
+        static CS sin(const CS& x) { return CS::fromComplex(std::sin(x.value())); }
+        static CS tan(const CS& x) { return CS::fromComplex(std::tan(x.value())); }
+        static CS asin(const CS& x) { return CS::fromComplex(std::asin(x.value())); }
+        static CS acos(const CS& x) { return CS::fromComplex(std::acos(x.value())); }
+        static CS atan(const CS& x) { return CS::fromComplex(std::atan(x.value())); }
+        static CS sinh(const CS& x) { return CS::fromComplex(std::sinh(x.value())); }
+        static CS cosh(const CS& x) { return CS::fromComplex(std::cosh(x.value())); }
+        static CS tanh(const CS& x) { return CS::fromComplex(std::tanh(x.value())); }
+        static CS exp(const CS& x) { return CS::fromComplex(std::exp(x.value())); }
+        static CS log(const CS& x) { return CS::fromComplex(std::log(x.value())); }
+        // |z| is not analytic: continue |x| from the real axis instead
+        static CS abs(const CS& x) { return x.real() < 0 ? -x : x; }
+        static CS floor(const CS& x) { return CS(std::floor(x.real())); }
+        static CS ceil(const CS& x) { return CS(std::ceil(x.real())); }
+        static CS pow(const CS& x, const CS& y) { return CS::fromComplex(std::pow(x.value(), y.value())); }
+        static CS powi(const CS& x, long n) { return _powi(x, n); }
+        template <int N>
+        static CS pown(const CS& x) { return _pown<N>::g(x); }
+        static CS hypot(const CS& x, const CS& y) { return sqrt(x*x+y*y); }
+        // the principal complex cube root is not the real one for x < 0
+        static CS cbrt(const CS& x) {
+          T r = std::cbrt(x.real());
+          return CS::fromComplex(std::complex<T>(r, x.value().imag()/(3*r*r)));
+        }
+        // atan2 has no complex extension: linearize in the imaginary parts
+        static CS atan2(const CS& y, const CS& x) {
+          T x0 = x.real(), y0 = y.real(), r = 1/(x0*x0+y0*y0);
+          T im = x0*r*y.value().imag() - y0*r*x.value().imag();
+          return CS::fromComplex(std::complex<T>(std::atan2(y0, x0), im));
+        }
+    };
+  }
+}
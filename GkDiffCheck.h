@@ -0,0 +1,163 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Verification of AD derivatives against finite differences, at
+// random points checked in parallel
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Gkyl {
+
+  /* Options of derivative checks */
+  struct DiffCheckOpts {
+      int npoints = 100; /* Number of random points */
+      int nthreads = 0; /* Number of threads (0: number of hardware threads) */
+      double lo = -1.0, up = 1.0; /* Inputs are uniform in [lo,up] */
+      unsigned long seed = 1; /* Random seed: points do not depend on nthreads */
+      double hrel = 0; /* Relative FD step (0: cube root of DBL_EPSILON) */
+      int nworst = 10; /* Number of worst errors to report */
+  };
+
+  /* Mismatch of one Jacobian entry at one point */
+  struct DiffCheckError {
+      std::vector<double> x; /* Point */
+      int out = 0, in = 0; /* Output and input index of Jacobian entry */
+      double ad = 0, fd = 0; /* AD and finite-difference derivatives */
+      double err = 0; /* Error |ad-fd|/max(1,|fd|) */
+  };
+
+  /* Result of derivative check */
+  struct DiffCheckResult {
+      long nchecked = 0; /* Number of Jacobian entries compared */
+      double maxErr = 0; /* Largest error */
+      std::vector<DiffCheckError> worst; /* Worst errors, largest first */
+  };
+
+  /* Jacobian (row-major, nout x nin) at x, using one forward sweep per
+   * W inputs with vector tangents. f(x,y) must be callable with
+   * std::vector of HyperReal<double,Lanes<double,W>> numbers */
+  template <int W=8, typename F>
+  void forwardJacobian(const F& f, const std::vector<double>& x, int nout, std::vector<double>& J) {
+    typedef HyperReal<double, Lanes<double,W> > VT;
+    int n = x.size();
+    std::vector<VT> hx(n), hy(nout);
+    for (int j=0; j<n; ++j) hx[j] = VT(x[j]);
+    J.assign(nout*n, 0.0);
+    for (int j0=0; j0<n; j0+=W) {
+      int nj = std::min(W, n-j0);
+      for (int k=0; k<nj; ++k) {
+        Lanes<double,W> seed(0.0);
+        seed[k] = 1.0;
+        hx[j0+k] = VT(x[j0+k], seed);
+      }
+      f(hx, hy);
+      for (int k=0; k<nj; ++k) hx[j0+k] = VT(x[j0+k]);
+      for (int i=0; i<nout; ++i)
+        for (int k=0; k<nj; ++k) J[i*n+j0+k] = hy[i].inf()[k];
+    }
+  }
+
+  /* Compares Jacobians computed by jac(x,J) to central differences of
+   * the primal function f(x,y), with x and y std::vector<double>, at
+   * random points. Points are split among threads, so f and jac must
+   * be safe to call concurrently */
+  template <typename F, typename JF>
+  DiffCheckResult diffCheckJacobian(const F& f, const JF& jac, int nin, int nout,
+    const DiffCheckOpts& opts = DiffCheckOpts()) {
+    int nthreads = opts.nthreads > 0 ? opts.nthreads : std::thread::hardware_concurrency();
+    nthreads = std::max(1, std::min(nthreads, opts.npoints));
+    double hrel = opts.hrel > 0 ? opts.hrel : std::cbrt(DBL_EPSILON);
+    auto worse = [](const DiffCheckError& a, const DiffCheckError& b) { return a.err > b.err; };
+
+    std::vector<DiffCheckResult> res(nthreads);
+    std::vector<std::exception_ptr> errs(nthreads);
+    std::atomic<int> next(0);
+
+    auto work = [&](int t) {
+      try {
+        std::vector<double> x(nin), xp(nin), yp(nout), ym(nout), J;
+        std::vector<DiffCheckError>& worst = res[t].worst;
+        for (int p = next++; p < opts.npoints; p = next++) {
+          // point depends only on seed and point index
+          std::mt19937_64 rng(opts.seed*1000003+p);
+          std::uniform_real_distribution<double> dist(opts.lo, opts.up);
+          for (int j=0; j<nin; ++j) xp[j] = x[j] = dist(rng);
+
+          jac(x, J);
+          for (int j=0; j<nin; ++j) {
+            // exactly representable step
+            volatile double xh = x[j] + hrel*std::max(1.0, std::fabs(x[j]));
+            double h = xh - x[j];
+            xp[j] = x[j]+h; f(xp, yp);
+            xp[j] = x[j]-h; f(xp, ym);
+            xp[j] = x[j];
+            for (int i=0; i<nout; ++i) {
+              double fd = (yp[i]-ym[i])/(2*h), ad = J[i*nin+j];
+              double err = std::fabs(ad-fd)/std::max(1.0, std::fabs(fd));
+              if (std::isnan(err)) err = std::isnan(ad) == std::isnan(fd) ? 0 : INFINITY;
+              res[t].nchecked++;
+              if (opts.nworst > 0 && ((int) worst.size() < opts.nworst || err > worst.back().err)) {
+                DiffCheckError e{x, i, j, ad, fd, err};
+                if ((int) worst.size() == opts.nworst) worst.pop_back();
+                worst.insert(std::upper_bound(worst.begin(), worst.end(), e, worse), e);
+              }
+              res[t].maxErr = std::max(res[t].maxErr, err);
+            }
+          }
+        }
+      }
+      catch (...) {
+        errs[t] = std::current_exception();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t=1; t<nthreads; ++t) threads.emplace_back(work, t);
+    work(0);
+    for (std::thread& th : threads) th.join();
+    for (std::exception_ptr& e : errs)
+      if (e) std::rethrow_exception(e);
+
+    // merge results of threads
+    DiffCheckResult r;
+    for (const DiffCheckResult& tr : res) {
+      r.nchecked += tr.nchecked;
+      r.maxErr = std::max(r.maxErr, tr.maxErr);
+      r.worst.insert(r.worst.end(), tr.worst.begin(), tr.worst.end());
+    }
+    std::stable_sort(r.worst.begin(), r.worst.end(), worse);
+    if ((int) r.worst.size() > opts.nworst) r.worst.resize(opts.nworst);
+    return r;
+  }
+
+  /* Checks forward-mode (HyperReal) derivatives of the templated
+   * function f(x,y), with x the nin inputs and y the nout outputs, both
+   * std::vector. f is called with vectors of double and of HyperReal
+   * numbers, so must be a generic lambda or a functor with a template
+   * call operator */
+  template <typename F>
+  DiffCheckResult diffCheck(const F& f, int nin, int nout,
+    const DiffCheckOpts& opts = DiffCheckOpts()) {
+    return diffCheckJacobian(f,
+      [&f, nout](const std::vector<double>& x, std::vector<double>& J) {
+        forwardJacobian(f, x, nout, J);
+      },
+      nin, nout, opts);
+  }
+}
@@ -0,0 +1,213 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Vector tangents with a width set at run time
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+#include <GkPool.h>
+
+// std includes
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+namespace Gkyl {
+
+  /* Pack of numbers, like Lanes, with the number of lanes given at
+   * run time. Up to K lanes are stored inline, more in an aligned block
+   * from the per-thread BlockPool, so intermediates do not allocate. A
+   * number made from a scalar, such as the zero tangent of a passive
+   * HyperReal, has no lanes and stands for the scalar in every lane:
+   * it takes the width of the numbers it is combined with. Use as the
+   * infinitesimal part of a HyperReal, HyperReal<double,DynLanes<double>>,
+   * with tangents of the inputs made by DynLanes<double>(n, 0.0) */
+  template <typename T, int K = 8>
+  class DynLanes {
+    public:
+      // various ctors
+      DynLanes() : n(0), c(-1), s(0), hp(0) { }
+      DynLanes(const T& s) : n(0), c(-1), s(s), hp(0) { }
+      // n lanes, all set to x
+      DynLanes(int n, const T& x) : DynLanes() { resize(n); fill(x); }
+      DynLanes(const DynLanes& x) : DynLanes() { copy(x); }
+      DynLanes(DynLanes&& x) noexcept : DynLanes() { steal(x); }
+      ~DynLanes() { resize(0); }
+
+      DynLanes& operator=(const DynLanes& x) {
+        if (this != &x) copy(x);
+        return *this;
+      }
+      DynLanes& operator=(DynLanes&& x) noexcept {
+        if (this != &x) steal(x);
+        return *this;
+      }
+
+      // n lanes, with s in lane i and zero in the others
+      static DynLanes unit(int n, int i, const T& s = T(1)) {
+        DynLanes r(n, T(0));
+        r.data()[i] = s;
+        return r;
+      }
+
+      // number of lanes (0 for a scalar)
+      int size() const { return n; }
+
+      // access to individual lanes. Only numbers with lanes can be
+      // written to
+      T operator[](int i) const { return n > 0 ? data()[i] : s; }
+      T& operator[](int i) { assert(i < n); return data()[i]; }
+
+      // compound assignment +=, -=, *=, /=
+      DynLanes& operator+=(const DynLanes& y) { return apply(y, [](T& a, const T& b) { a += b; }); }
+      DynLanes& operator-=(const DynLanes& y) { return apply(y, [](T& a, const T& b) { a -= b; }); }
+      DynLanes& operator*=(const DynLanes& y) { return apply(y, [](T& a, const T& b) { a *= b; }); }
+      // the unused inline lanes, 0/0, are left alone so that no
+      // spurious FE_INVALID is raised
+      DynLanes& operator/=(const DynLanes& y) { return apply(y, [](T& a, const T& b) { a /= b; }, true); }
+      DynLanes& operator*=(const T& t) { scale(t); return *this; }
+
+      // binary +, -, *, /. The scalar overloads avoid making a number
+      // to hold the scalar
+      friend DynLanes operator+(DynLanes x, const DynLanes& y) { x += y; return x; }
+      friend DynLanes operator-(DynLanes x, const DynLanes& y) { x -= y; return x; }
+      friend DynLanes operator*(DynLanes x, const DynLanes& y) { x *= y; return x; }
+      friend DynLanes operator/(DynLanes x, const DynLanes& y) { x /= y; return x; }
+      friend DynLanes operator*(DynLanes x, const T& t) { x.scale(t); return x; }
+      friend DynLanes operator*(const T& t, DynLanes x) { x.scale(t); return x; }
+      friend DynLanes operator/(DynLanes x, const T& t) { x.scale(1/t); return x; }
+
+      // unary -, +
+      DynLanes operator-() const { DynLanes r(*this); r.scale(T(-1)); return r; }
+      DynLanes operator+() const { return *this; }
+
+      // a*t+c in one pass, fused in each lane. This is found by
+      // argument-dependent lookup from the HyperReal operators, in
+      // preference to the unfused generic _fma
+      friend DynLanes _fma(const DynLanes& a, const T& t, DynLanes c) {
+        if (a.n == 0) { c += DynLanes(a.s*t); return c; }
+        if (c.n == 0) {
+          T x = c.s;
+          c.resize(a.n);
+          c.fill(x);
+        }
+        assert(a.n == c.n);
+        if (c.c < 0)
+          for (int i=0; i<K; ++i) c.v[i] = _fma(a.v[i], t, c.v[i]);
+        else
+          for (int i=0; i<c.n; ++i) c.hp[i] = _fma(a.hp[i], t, c.hp[i]);
+        return c;
+      }
+
+      // true if all lanes are zero: found by argument-dependent lookup
+      // where the HyperReal rules skip terms scaled by a zero tangent
+      friend bool _isZero(const DynLanes& x) {
+        if (x.n == 0) return x.s == T(0);
+        const T *p = x.data();
+        for (int i=0; i<x.n; ++i) if (p[i] != T(0)) return false;
+        return true;
+      }
+
+    private:
+      int n; /* Number of lanes */
+      int c; /* Size class of pooled block (-1: inline storage) */
+      T s; /* Value of every lane if n is 0 */
+      T *hp; /* Values in pooled block */
+      T v[K] = {}; /* Inline values */
+
+      // Up to K lanes are always inline, and more always pooled, so
+      // two numbers with the same number of lanes have the same kind of
+      // storage. Inline loops run over all K lanes, so that their trip
+      // count is known at compile time: the unused lanes are never
+      // read
+
+      const T* data() const { return c < 0 ? v : hp; }
+      T* data() { return c < 0 ? v : hp; }
+
+      // make room for m lanes, discarding the current ones
+      void resize(int m) {
+        if (m <= K) {
+          if (c >= 0) BlockPool::release(hp, c);
+          c = -1;
+        }
+        else if (c < 0 || BlockPool::blockSize(c) < m*sizeof(T)) {
+          if (c >= 0) BlockPool::release(hp, c);
+          c = BlockPool::sizeClass(m*sizeof(T));
+          hp = static_cast<T*>(BlockPool::get(c));
+        }
+        n = m;
+      }
+
+      void fill(const T& x) {
+        if (c < 0) for (int i=0; i<K; ++i) v[i] = x;
+        else for (int i=0; i<n; ++i) hp[i] = x;
+      }
+
+      void copy(const DynLanes& x) {
+        resize(x.n);
+        s = x.s;
+        if (n == 0) return;
+        // copying trivial values with memcpy lets the compiler use a
+        // few vector moves, rather than a call to memmove
+        if constexpr (std::is_trivially_copyable<T>::value) {
+          if (c < 0) std::memcpy(v, x.v, sizeof(v));
+          else std::memcpy(hp, x.hp, n*sizeof(T));
+        }
+        else {
+          if (c < 0) for (int i=0; i<K; ++i) v[i] = x.v[i];
+          else for (int i=0; i<n; ++i) hp[i] = x.hp[i];
+        }
+      }
+
+      // take lanes of x, leaving it a scalar. A pooled block is moved
+      // rather than copied
+      void steal(DynLanes& x) {
+        if (x.c < 0) copy(x);
+        else {
+          resize(0);
+          n = x.n; c = x.c; s = x.s; hp = x.hp;
+          x.c = -1;
+        }
+        x.n = 0;
+      }
+
+      void scale(const T& t) {
+        if (n == 0) s *= t;
+        else if (c < 0) for (int i=0; i<K; ++i) v[i] *= t;
+        else for (int i=0; i<n; ++i) hp[i] *= t;
+      }
+
+      // apply op(a,b) to each lane a of this and b of y, broadcasting
+      // a scalar operand. Inline lanes are all processed, for a loop of
+      // fixed length, unless 'used' asks for the n lanes in use only
+      template <typename Op>
+      DynLanes& apply(const DynLanes& y, Op op, bool used = false) {
+        if (y.n == 0) {
+          if (n == 0) op(s, y.s);
+          else if (c < 0) for (int i=0, m=used ? n : K; i<m; ++i) op(v[i], y.s);
+          else for (int i=0; i<n; ++i) op(hp[i], y.s);
+          return *this;
+        }
+        if (n == 0) {
+          T x = s;
+          resize(y.n);
+          fill(x);
+        }
+        assert(n == y.n);
+        if (c < 0) for (int i=0, m=used ? n : K; i<m; ++i) op(v[i], y.v[i]);
+        else for (int i=0; i<n; ++i) op(hp[i], y.hp[i]);
+        return *this;
+      }
+  };
+
+  namespace {
+    /* DynLanes tangents are scaled by a scalar */
+    template <typename T, int K, typename RT>
+    struct _S<DynLanes<T,K>, RT> { typedef typename _S<T,RT>::type type; };
+  }
+}
@@ -9,12 +9,21 @@
 #pragma once
 
 // std includes
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <type_traits>
+#include <utility>
 
 namespace Gkyl {
   
   template <typename RT, typename AT> class HyperReal;
+  template <typename T, int N, int A = 0> class Lanes;
+  class BFloat16;
 
   // Private types to extract real and adjoint parts from a
   // number. The number can be a POD (double/float) or a HyperReal
@@ -22,142 +31,547 @@ namespace Gkyl {
     /* Fetch real part of POD number */
     template <typename T>
     struct _R {
-        static T g(T r) { return r; }
+        constexpr static T g(T r) { return r; }
     };
     /* Fetch infinitesimal part of POD number */
     template <typename T>
     struct _I {
-        static T g(T r) { return 0; }
+        constexpr static T g(T r) { return 0; }
     };
 
     /* Fetch real part of HyperReal number */
     template <typename RT, typename AT>
     struct _R<HyperReal<RT, AT> > {
-        static RT g(const HyperReal<RT, AT>& r) { return r.real(); }
+        constexpr static RT g(const HyperReal<RT, AT>& r) { return r.real(); }
     };
     /* Fetch infinitesimal part of HyperReal number */
     template <typename RT, typename AT>
     struct _I<HyperReal<RT, AT> > {
-        static AT g(const HyperReal<RT, AT>& r) { return r.inf(); }
+        constexpr static const AT& g(const HyperReal<RT, AT>& r) { return r.inf(); }
     };
+
+    /* Check if number is a HyperReal number */
+    template <typename T>
+    struct _A {
+        static constexpr bool value = false;
+    };
+    template <typename RT, typename AT>
+    struct _A<HyperReal<RT, AT> > {
+        static constexpr bool value = true;
+    };
+
+    /* Type that derivative factors, computed in the real type RT, are
+     * converted to before scaling an infinitesimal part of type AT. This
+     * keeps arithmetic on reduced-precision tangents in their own
+     * precision */
+    template <typename AT, typename RT>
+    struct _S { typedef AT type; };
+    /* bfloat16 tangents are scaled in float */
+    template <typename RT>
+    struct _S<BFloat16, RT> { typedef float type; };
+    /* Vector tangents are scaled by a scalar ... */
+    template <typename T, int N, int A, typename RT>
+    struct _S<Lanes<T,N,A>, RT> { typedef typename _S<T,RT>::type type; };
+    /* ... unless the real part is packed too */
+    template <typename T, int N, int A, typename U, int B>
+    struct _S<Lanes<T,N,A>, Lanes<U,N,B> > { typedef Lanes<typename _S<T,U>::type,N,A> type; };
+
+    /* Enabled if S is the type that derivative factors are converted
+     * to before scaling numbers of type T (_S), and is not T */
+    template <typename S, typename T>
+    using _IfScale = typename std::enable_if<!std::is_same<S,T>::value
+                                             && std::is_same<S, typename _S<T,S>::type>::value>::type;
+
+    /* Convert number of type T to S, without a copy if the types are
+     * the same */
+    template <typename S, typename T>
+    struct _cv {
+        constexpr static S g(const T& x) { return S(x); }
+    };
+    template <typename S>
+    struct _cv<S, S> {
+        constexpr static const S& g(const S& x) { return x; }
+    };
+
+    /* Derivative factor f, converted to scale infinitesimal part of
+     * type AT */
+    template <typename AT, typename RT>
+    constexpr inline auto _d(const RT& f) -> decltype(_cv<typename _S<AT,RT>::type, RT>::g(f)) {
+      return _cv<typename _S<AT,RT>::type, RT>::g(f);
+    }
+
+    /* True in constant evaluation (std::is_constant_evaluated of C++20,
+     * available in C++17 as a builtin in GCC, Clang and MSVC) */
+    constexpr inline bool _isConstEval() {
+      return __builtin_is_constant_evaluated();
+    }
+
+    /* a*b+c, with a single rounding where the hardware has fused
+     * multiply-add (std::fma is a slow library call otherwise). std::fma
+     * is not constexpr, so constant evaluation is unfused */
+    constexpr inline double _fma(double a, double b, double c) {
+#ifdef FP_FAST_FMA
+      if (!_isConstEval()) return std::fma(a, b, c);
+#endif
+      return a*b+c;
+    }
+    constexpr inline float _fma(float a, float b, float c) {
+#ifdef FP_FAST_FMAF
+      if (!_isConstEval()) return std::fma(a, b, c);
+#endif
+      return a*b+c;
+    }
+    /* True where _fma of T is fused */
+    template <typename T>
+    struct _fastFma { static constexpr bool value = false; };
+#ifdef FP_FAST_FMA
+    template <>
+    struct _fastFma<double> { static constexpr bool value = true; };
+#endif
+#ifdef FP_FAST_FMAF
+    template <>
+    struct _fastFma<float> { static constexpr bool value = true; };
+#endif
+
+    /* x/y given r = 1/y, so that the quotient rule, which needs r for
+     * the derivative, does one division. With fused multiply-add, x*r
+     * corrected once by (x - q y) r is the correctly rounded quotient
+     * (Markstein), i.e. x/y bit for bit, while x, y and the quotient
+     * are well inside the exponent range. Outside it, and without a
+     * fused multiply-add, this is x/y */
+    template <typename T>
+    constexpr inline T _quot(const T& x, const T& y, const T& r) {
+      if constexpr (_fastFma<T>::value) {
+        constexpr T e2 = std::numeric_limits<T>::epsilon()*std::numeric_limits<T>::epsilon();
+        constexpr T lo = std::numeric_limits<T>::min()/e2, hi = std::numeric_limits<T>::max()*e2;
+        if (!_isConstEval()) {
+          T q = x*r, ax = x < 0 ? -x : x, ay = y < 0 ? -y : y, aq = q < 0 ? -q : q;
+          if (ax > lo && ax < hi && ay > lo && ay < hi && aq > lo && aq < hi)
+            return std::fma(std::fma(-q, y, x), r, q);
+        }
+      }
+      return x/y;
+    }
+
+    /* Other types: no fused operation */
+    template <typename A, typename B, typename C>
+    constexpr inline auto _fma(const A& a, const B& b, const C& c) -> decltype(a*b+c) {
+      return a*b+c;
+    }
+    /* a*s+b*t and (a*s+c)*t: the two-term tangent updates of the
+     * product, quotient and two-argument rules. Reduced-precision
+     * lanes (BFloat16) keep the intermediate in the scale type, so each
+     * lane is rounded once, as a single number is */
+    template <typename A, typename S>
+    constexpr inline auto _fma2(const A& a, const S& s, const A& b, const S& t) -> decltype(_fma(a, s, b*t)) {
+      return _fma(a, s, b*t);
+    }
+    template <typename A, typename S>
+    constexpr inline auto _fmaMul(const A& a, const S& s, const A& c, const S& t) -> decltype(_fma(a, s, c)*t) {
+      return _fma(a, s, c)*t;
+    }
+    template <typename T, int N, int A, typename S>
+    inline Lanes<T,N,A> _fma2(const Lanes<T,N,A>& a, const S& s, const Lanes<T,N,A>& b, const S& t) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = T(_fma(a[i], s, b[i]*t));
+      return r;
+    }
+    template <typename T, int N, int A, typename S>
+    inline Lanes<T,N,A> _fmaMul(const Lanes<T,N,A>& a, const S& s, const Lanes<T,N,A>& c, const S& t) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = T(_fma(a[i], s, c[i])*t);
+      return r;
+    }
+    /* Lanes scaled by lanes (packed real parts) */
+    template <typename T, int N, int A>
+    inline Lanes<T,N,A> _fma2(const Lanes<T,N,A>& a, const Lanes<T,N,A>& s, const Lanes<T,N,A>& b, const Lanes<T,N,A>& t) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = _fma(a[i], s[i], b[i]*t[i]);
+      return r;
+    }
+    template <typename T, int N, int A>
+    inline Lanes<T,N,A> _fmaMul(const Lanes<T,N,A>& a, const Lanes<T,N,A>& s, const Lanes<T,N,A>& c, const Lanes<T,N,A>& t) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = _fma(a[i], s[i], c[i])*t[i];
+      return r;
+    }
+
+    /* True if tangent t is zero, so that the terms it scales can be
+     * skipped. Tangent types with lanes provide their own as hidden
+     * friends */
+    template <typename A>
+    inline bool _isZero(const A& t) { return t == A(0); }
+    template <typename T, int N, int A>
+    inline bool _isZero(const Lanes<T,N,A>& t) {
+      bool z = true;
+      for (int i=0; i<N; ++i) z = z && _isZero(t[i]);
+      return z;
+    }
+
+    /* Lanes, scaled by lanes or a scalar: fused in each lane */
+    template <typename T, int N, int A, typename S>
+    inline Lanes<T,N,A> _fma(const Lanes<T,N,A>& a, const S& b, const Lanes<T,N,A>& c) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = _fma(a[i], b, c[i]);
+      return r;
+    }
+    template <typename T, int N, int A>
+    inline Lanes<T,N,A> _fma(const Lanes<T,N,A>& a, const Lanes<T,N,A>& b, const Lanes<T,N,A>& c) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = _fma(a[i], b[i], c[i]);
+      return r;
+    }
   }
 
   /* Hyperreal number: real + infinitesimal (adjoint). RT is type of
-   * the real-part and AT the type of the adoint part */
+   * the real-part and AT the type of the adoint part. AT can have lower
+   * precision than RT, e.g. HyperReal<double,float> to halve the
+   * memory used by tangents */
   template <typename RT, typename AT=RT>
   class HyperReal {
     public:
       // various ctors
-      HyperReal() : rp(0), ip(0) { }
-      HyperReal(const RT& rel) : rp(rel), ip(0) { }
-      HyperReal(const RT& rel, const AT& inf) : rp(rel), ip(inf) { }
+      constexpr HyperReal() : rp(0), ip(0) { }
+      constexpr HyperReal(const RT& rel) : rp(rel), ip(0) { }
+      constexpr HyperReal(const RT& rel, const AT& inf) : rp(rel), ip(inf) { }
+      // moves infinitesimal parts that own storage
+      constexpr HyperReal(const RT& rel, AT&& inf) : rp(rel), ip(std::move(inf)) { }
 
       // real and infinitesimal parts of number
-      RT real() const { return rp; }
-      AT inf() const { return ip; }
+      constexpr RT real() const { return rp; }
+      constexpr const AT& inf() const { return ip; }
 
       // assignment =
       template<typename RHT>
-      HyperReal& operator=(const RHT& rv) {
-        RT y0 = _R<RHT>::g(rv); AT y1 = _I<RHT>::g(rv);
-        rp = y0; ip = y1;
+      constexpr HyperReal& operator=(const RHT& rv) {
+        rp = _R<RHT>::g(rv); ip = AT(_I<RHT>::g(rv));
         return *this;    
       }
 
+      // Compound assignments update the parts in place. A passive
+      // right-hand side does not touch the infinitesimal part beyond
+      // the scaling needed by *= and /=
+
       // compound assignment +=
       template <typename RHT>
-      HyperReal& operator+=(const RHT& rv) {
-        RT y0 = _R<RHT>::g(rv); AT y1 = _I<RHT>::g(rv);
-        rp += y0; ip += y1;
+      constexpr HyperReal& operator+=(const RHT& rv) {
+        rp += _R<RHT>::g(rv);
+        if constexpr (_A<RHT>::value) ip += _I<RHT>::g(rv);
         return *this;
       }
       // compound assignment -=
       template <typename RHT>
-      HyperReal& operator-=(const RHT& rv) {
-        RT y0 = _R<RHT>::g(rv); AT y1 = _I<RHT>::g(rv);
-        rp -= y0; ip -= y1;
+      constexpr HyperReal& operator-=(const RHT& rv) {
+        rp -= _R<RHT>::g(rv);
+        if constexpr (_A<RHT>::value) ip -= _I<RHT>::g(rv);
         return *this;
       }
-      // compound assignment *=
+      // compound assignment *=: d(xy) = y dx + x dy
       template <typename RHT>
-      HyperReal& operator*=(const RHT& rv) {
-        RT y0 = _R<RHT>::g(rv); AT y1 = _I<RHT>::g(rv);
-        rp *= y0; ip *= y1;
+      constexpr HyperReal& operator*=(const RHT& rv) {
+        RT y0 = _R<RHT>::g(rv);
+        if constexpr (_A<RHT>::value) ip = _fma2(ip, _d<AT>(y0), _I<RHT>::g(rv), _d<AT>(rp));
+        else ip *= _d<AT>(y0);
+        rp *= y0;
         return *this;
       }
-      // compound assignment /=
+      // compound assignment /=: d(x/y) = (dx - (x/y) dy)/y
       template <typename RHT>
-      HyperReal& operator/=(const RHT& rv) {
-        RT y0 = _R<RHT>::g(rv); AT y1 = _I<RHT>::g(rv);
-        rp /= y0; ip /= y1;
+      constexpr HyperReal& operator/=(const RHT& rv) {
+        RT y0 = _R<RHT>::g(rv);
+        RT r = 1/y0, q = _quot(rp, y0, r);
+        if constexpr (_A<RHT>::value) ip = _fmaMul(_I<RHT>::g(rv), _d<AT>(-q), ip, _d<AT>(r));
+        else ip *= _d<AT>(r);
+        rp = q;
         return *this;
       }
 
+      // Binary operators only accept operands one of which is a
+      // HyperReal: otherwise these would be found by ADL for, say,
+      // iterators of containers of HyperReal numbers. A passive
+      // operand is known at compile time, so no arithmetic is done on
+      // its (zero) infinitesimal part
+
       // binary +
       template <typename LHT, typename RHT>
-      friend HyperReal operator+(const LHT& lv, const RHT& rv) {
+      friend constexpr typename std::enable_if<_A<LHT>::value || _A<RHT>::value, HyperReal>::type
+      operator+(const LHT& lv, const RHT& rv) {
         RT x0 = _R<LHT>::g(lv), y0 = _R<RHT>::g(rv);
-        AT x1 = _I<LHT>::g(lv), y1 = _I<RHT>::g(rv);
-        return HyperReal<RT,AT>(x0+y0, x1+y1);
+        if constexpr (!_A<RHT>::value) return HyperReal<RT,AT>(x0+y0, _I<LHT>::g(lv));
+        else if constexpr (!_A<LHT>::value) return HyperReal<RT,AT>(x0+y0, _I<RHT>::g(rv));
+        else return HyperReal<RT,AT>(x0+y0, _I<LHT>::g(lv)+_I<RHT>::g(rv));
       }
       // binary -
       template <typename LHT, typename RHT>
-      friend HyperReal operator-(const LHT& lv, const RHT& rv) {
+      friend constexpr typename std::enable_if<_A<LHT>::value || _A<RHT>::value, HyperReal>::type
+      operator-(const LHT& lv, const RHT& rv) {
         RT x0 = _R<LHT>::g(lv), y0 = _R<RHT>::g(rv);
-        AT x1 = _I<LHT>::g(lv), y1 = _I<RHT>::g(rv);
-        return HyperReal<RT,AT>(x0-y0, x1-y1);
+        if constexpr (!_A<RHT>::value) return HyperReal<RT,AT>(x0-y0, _I<LHT>::g(lv));
+        else if constexpr (!_A<LHT>::value) return HyperReal<RT,AT>(x0-y0, -_I<RHT>::g(rv));
+        else return HyperReal<RT,AT>(x0-y0, _I<LHT>::g(lv)-_I<RHT>::g(rv));
       }
       // binary *
       template <typename LHT, typename RHT>
-      friend HyperReal operator*(const LHT& lv, const RHT& rv) {
+      friend constexpr typename std::enable_if<_A<LHT>::value || _A<RHT>::value, HyperReal>::type
+      operator*(const LHT& lv, const RHT& rv) {
         RT x0 = _R<LHT>::g(lv), y0 = _R<RHT>::g(rv);
-        AT x1 = _I<LHT>::g(lv), y1 = _I<RHT>::g(rv);
-        return HyperReal<RT,AT>(x0*y0, x0*y1+x1*y0);
+        // a passive factor only scales the other infinitesimal part
+        if constexpr (!_A<RHT>::value) return HyperReal<RT,AT>(x0*y0, _I<LHT>::g(lv)*_d<AT>(y0));
+        else if constexpr (!_A<LHT>::value) return HyperReal<RT,AT>(x0*y0, _I<RHT>::g(rv)*_d<AT>(x0));
+        else {
+          const AT& x1 = _I<LHT>::g(lv), &y1 = _I<RHT>::g(rv);
+          return HyperReal<RT,AT>(x0*y0, _fma2(x1, _d<AT>(y0), y1, _d<AT>(x0)));
+        }
       }
       // binary /
       template <typename LHT, typename RHT>
-      friend HyperReal operator/(const LHT& lv, const RHT& rv) {
+      friend constexpr typename std::enable_if<_A<LHT>::value || _A<RHT>::value, HyperReal>::type
+      operator/(const LHT& lv, const RHT& rv) {
         RT x0 = _R<LHT>::g(lv), y0 = _R<RHT>::g(rv);
-        AT x1 = _I<LHT>::g(lv), y1 = _I<RHT>::g(rv);
-        return HyperReal<RT,AT>(x0/y0, -(x0*y1-x1*y0)/(y0*y0));
+        // d(x/y) = (dx - (x/y) dy)/y: the value and the tangent share
+        // the reciprocal of y, and the value is still the primal
+        // quotient, bit for bit
+        RT r = 1/y0, q = _quot(x0, y0, r);
+        if constexpr (!_A<RHT>::value) return HyperReal<RT,AT>(q, _I<LHT>::g(lv)*_d<AT>(r));
+        else if constexpr (!_A<LHT>::value) return HyperReal<RT,AT>(q, _I<RHT>::g(rv)*_d<AT>(-q*r));
+        else {
+          const AT& x1 = _I<LHT>::g(lv), &y1 = _I<RHT>::g(rv);
+          return HyperReal<RT,AT>(q, _fmaMul(y1, _d<AT>(-q), x1, _d<AT>(r)));
+        }
       }
 
       // unary -, +
-      HyperReal operator-() { return HyperReal<RT,AT>(-rp, -ip); }
-      HyperReal operator+() { return HyperReal<RT,AT>(rp, ip); }
+      constexpr HyperReal operator-() const { return HyperReal<RT,AT>(-rp, -ip); }
+      constexpr HyperReal operator+() const { return HyperReal<RT,AT>(rp, ip); }
 
-      // relational <
-      template<typename LHT, typename RHT>
-      friend bool operator<(const LHT& lv, const RHT& rv) {
-        return _R<LHT>::g(lv) < _R<RHT>::g(rv);
-      }
-      // relational >
-      template<typename LHT, typename RHT>
-      friend bool operator>(const LHT& lv, const RHT& rv) { return rv < lv; }
-      // relational <=
-      template<typename LHT, typename RHT>
-      friend bool operator<=(const LHT& lv, const RHT& rv) { return !(lv > rv); }
-      // relational >=
-      template<typename LHT, typename RHT>
-      friend bool operator>=(const LHT& lv, const RHT& rv) { return !(lv < rv); }
-
-      // equality == 
-      template<typename LHT, typename RHT>
-      friend bool operator==(const LHT& lv, const RHT& rv) {
-        return _R<LHT>::g(lv) == _R<RHT>::g(rv);
-      }
-      // inequality != 
-      template<typename LHT, typename RHT>
-      friend bool operator!=(const LHT& lv, const RHT& rv) { return !(lv == rv); }
-      
     private:
       RT rp; /* Real part */
       AT ip; /* Infinitesimal part */
   };
 
+  // Relational operators compare real parts. These are not friends of
+  // HyperReal as their signature does not depend on the HyperReal type
+  // and would be redefined for each type used.
+
+  // relational <
+  template<typename LHT, typename RHT>
+  constexpr inline typename std::enable_if<_A<LHT>::value || _A<RHT>::value, bool>::type
+  operator<(const LHT& lv, const RHT& rv) {
+    return _R<LHT>::g(lv) < _R<RHT>::g(rv);
+  }
+  // relational >
+  template<typename LHT, typename RHT>
+  constexpr inline typename std::enable_if<_A<LHT>::value || _A<RHT>::value, bool>::type
+  operator>(const LHT& lv, const RHT& rv) { return rv < lv; }
+  // relational <=
+  template<typename LHT, typename RHT>
+  constexpr inline typename std::enable_if<_A<LHT>::value || _A<RHT>::value, bool>::type
+  operator<=(const LHT& lv, const RHT& rv) { return !(lv > rv); }
+  // relational >=
+  template<typename LHT, typename RHT>
+  constexpr inline typename std::enable_if<_A<LHT>::value || _A<RHT>::value, bool>::type
+  operator>=(const LHT& lv, const RHT& rv) { return !(lv < rv); }
+
+  // equality ==
+  template<typename LHT, typename RHT>
+  constexpr inline typename std::enable_if<_A<LHT>::value || _A<RHT>::value, bool>::type
+  operator==(const LHT& lv, const RHT& rv) {
+    return _R<LHT>::g(lv) == _R<RHT>::g(rv);
+  }
+  // inequality !=
+  template<typename LHT, typename RHT>
+  constexpr inline typename std::enable_if<_A<LHT>::value || _A<RHT>::value, bool>::type
+  operator!=(const LHT& lv, const RHT& rv) { return !(lv == rv); }
+
+  /* Storage-only bfloat16 number: the upper 16 bits of a float. Used
+   * as (part of) the infinitesimal type of a HyperReal where
+   * derivatives are only needed to 2-3 digits. Arithmetic is done in
+   * float, and results are rounded to nearest-even when stored */
+  class BFloat16 {
+    public:
+      // various ctors
+      BFloat16() : b(0) { }
+      BFloat16(float f) : b(round(f)) { }
+
+      // conversion to float is exact
+      operator float() const {
+        uint32_t u = uint32_t(b) << 16;
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+      }
+
+      // compound assignment +=, -=, *=, /=
+      BFloat16& operator+=(float y) { b = round(float(*this)+y); return *this; }
+      BFloat16& operator-=(float y) { b = round(float(*this)-y); return *this; }
+      BFloat16& operator*=(float y) { b = round(float(*this)*y); return *this; }
+      BFloat16& operator/=(float y) { b = round(float(*this)/y); return *this; }
+
+    private:
+      uint16_t b; /* Bits */
+
+      static uint16_t round(float f) {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        uint32_t r = (u + 0x7fff + ((u >> 16) & 1)) >> 16;
+        // select, rather than branch, so that loops over lanes vectorize
+        return (u & 0x7fffffff) > 0x7f800000 ? (u >> 16) | 0x40 : r; // quiet NaN
+      }
+  };
+
   // Predefined types
   using HyperDouble = HyperReal<double>;
   using HyperFloat = HyperReal<float>;
+  // double values with reduced-precision tangents
+  using HyperDoubleF = HyperReal<double,float>;
+  using HyperDoubleBF = HyperReal<double,BFloat16>;
+
+  /* Fixed-width pack of N numbers with element-wise arithmetic. Can
+   * be used as the real and infinitesimal parts of a HyperReal to
+   * evaluate a function at N points in a single call. The loops are
+   * over a fixed-size array and are vectorized by the compiler. The
+   * lanes are aligned to A bytes, and padded to a multiple of A (A = 0:
+   * alignment of T); see AlignedLanes */
+  template <typename T, int N, int A>
+  class Lanes {
+    public:
+      // number of lanes
+      static const int width = N;
+
+      // various ctors
+      Lanes() : Lanes(T(0)) { }
+      Lanes(const T& s) { for (int i=0; i<N; ++i) v[i] = s; }
+      template <typename U, int B>
+      explicit Lanes(const Lanes<U,N,B>& x) { for (int i=0; i<N; ++i) v[i] = T(x[i]); }
+
+      // load N numbers stored contiguously
+      static Lanes load(const T *p) {
+        Lanes r;
+        for (int i=0; i<N; ++i) r.v[i] = p[i];
+        return r;
+      }
+
+      // access to individual lanes
+      T& operator[](int i) { return v[i]; }
+      const T& operator[](int i) const { return v[i]; }
+
+      // compound assignment +=, -=, *=, /=
+      Lanes& operator+=(const Lanes& y) { for (int i=0; i<N; ++i) v[i] += y.v[i]; return *this; }
+      Lanes& operator-=(const Lanes& y) { for (int i=0; i<N; ++i) v[i] -= y.v[i]; return *this; }
+      Lanes& operator*=(const Lanes& y) { for (int i=0; i<N; ++i) v[i] *= y.v[i]; return *this; }
+      Lanes& operator/=(const Lanes& y) { for (int i=0; i<N; ++i) v[i] /= y.v[i]; return *this; }
+
+      // binary +
+      friend Lanes operator+(const Lanes& x, const Lanes& y) { Lanes r(x); return r += y; }
+      friend Lanes operator+(const Lanes& x, const T& y) { Lanes r(x); return r += Lanes(y); }
+      friend Lanes operator+(const T& x, const Lanes& y) { Lanes r(x); return r += y; }
+      // binary -
+      friend Lanes operator-(const Lanes& x, const Lanes& y) { Lanes r(x); return r -= y; }
+      friend Lanes operator-(const Lanes& x, const T& y) { Lanes r(x); return r -= Lanes(y); }
+      friend Lanes operator-(const T& x, const Lanes& y) { Lanes r(x); return r -= y; }
+      // binary *
+      friend Lanes operator*(const Lanes& x, const Lanes& y) { Lanes r(x); return r *= y; }
+      friend Lanes operator*(const Lanes& x, const T& y) { Lanes r(x); return r *= Lanes(y); }
+      friend Lanes operator*(const T& x, const Lanes& y) { Lanes r(x); return r *= y; }
+      // binary /
+      friend Lanes operator/(const Lanes& x, const Lanes& y) { Lanes r(x); return r /= y; }
+      friend Lanes operator/(const Lanes& x, const T& y) { Lanes r(x); return r /= Lanes(y); }
+      friend Lanes operator/(const T& x, const Lanes& y) { Lanes r(x); return r /= y; }
+
+      // scaling by the type that derivative factors of T are converted
+      // to (_S), where that is not T, e.g. float for BFloat16 lanes:
+      // each lane is scaled in that type and rounded once
+      template <typename S, typename = _IfScale<S,T> >
+      Lanes& operator*=(const S& s) { for (int i=0; i<N; ++i) v[i] = T(v[i]*s); return *this; }
+      template <typename S, typename = _IfScale<S,T> >
+      friend Lanes operator*(const Lanes& x, const S& s) { Lanes r(x); return r *= s; }
+      template <typename S, typename = _IfScale<S,T> >
+      friend Lanes operator*(const S& s, const Lanes& x) { Lanes r(x); return r *= s; }
+
+      // unary -, +
+      Lanes operator-() const { Lanes r; for (int i=0; i<N; ++i) r.v[i] = -v[i]; return r; }
+      Lanes operator+() const { return *this; }
+
+    private:
+      alignas(A > int(alignof(T)) ? A : int(alignof(T))) T v[N]; /* Values in each lane */
+  };
+
+  /* Default alignment cap of AlignedLanes, in bytes: a cache line,
+   * and the widest vector register (AVX-512). Fixed rather than taken
+   * from the target flags, so that AlignedLanes has the same layout in
+   * every translation unit */
+  constexpr int simdBytes = 64;
+
+  /* Alignment of AlignedLanes: the smallest power of two that holds
+   * the lanes, up to V bytes */
+  template <typename T, int N, int V = simdBytes>
+  constexpr int laneAlign() {
+    int a = alignof(T);
+    while (a < V && a < int(N*sizeof(T))) a *= 2;
+    return a;
+  }
+
+  /* Lanes aligned and padded for vector loads. As the infinitesimal
+   * part of a HyperReal, the tangents of each element of an array then
+   * start on a vector boundary, so that no vector load of them splits
+   * a cache line, at the cost of padding. Lower V to pad less when
+   * the lanes are wider than the vector registers used. std::vector
+   * aligns these itself; use AlignedAllocator (GkPool.h) to also start
+   * arrays on a cache line */
+  template <typename T, int N, int V = simdBytes>
+  using AlignedLanes = Lanes<T, N, laneAlign<T,N,V>()>;
+
+  namespace {
+    /* Sum of p[0], ..., p[N-1] by pairwise halving. The additions at
+     * each level are independent, so they vectorize without the
+     * reassociation a serial sum needs (-ffast-math), and the
+     * rounding error grows as log N rather than N */
+    template <typename T, int N>
+    inline T _tsum(T (&p)[N]) {
+      for (int m=N; m>1; m=(m+1)/2)
+        for (int i=0; i<m/2; ++i) p[i] += p[i+(m+1)/2];
+      return p[0];
+    }
+  }
+
+  /* Sum of all lanes */
+  template <typename T, int N, int A>
+  inline T sum(const Lanes<T,N,A>& x) {
+    T p[N];
+    for (int i=0; i<N; ++i) p[i] = x[i];
+    return _tsum(p);
+  }
+
+  /* Weighted sum of all lanes: sum_i w[i]*x[i]. The products are
+   * formed lane-wise and then summed pairwise */
+  template <typename WT, typename T, int N, int B, int A>
+  inline T wsum(const Lanes<WT,N,B>& w, const Lanes<T,N,A>& x) {
+    T p[N];
+    for (int i=0; i<N; ++i) p[i] = w[i]*x[i];
+    return _tsum(p);
+  }
+
+  // HyperReal numbers with fixed-size parts are laid out as the real
+  // part followed by the infinitesimal part, with no other data, and
+  // can be copied as bytes: arrays of them can be memcpy'd to and from
+  // interleaved (value, tangent) buffers, and sent as raw bytes. The
+  // tangents that own storage (GkBlockLanes.h, GkSparseTangent.h,
+  // GkDynLanes.h) are not trivially copyable
+  namespace {
+    template <typename H, typename RT, typename AT>
+    constexpr bool _isPlain() {
+      return std::is_trivially_copyable<H>::value && std::is_standard_layout<H>::value
+        && sizeof(H) == sizeof(std::pair<RT,AT>) && alignof(H) == alignof(std::pair<RT,AT>);
+    }
+  }
+  static_assert(_isPlain<HyperDouble, double, double>() && sizeof(HyperDouble) == 2*sizeof(double),
+    "HyperDouble must be two doubles");
+  static_assert(_isPlain<HyperFloat, float, float>() && sizeof(HyperFloat) == 2*sizeof(float),
+    "HyperFloat must be two floats");
+  static_assert(_isPlain<HyperDoubleF, double, float>(), "HyperDoubleF must be plain data");
+  static_assert(_isPlain<HyperDoubleBF, double, BFloat16>(), "HyperDoubleBF must be plain data");
+  static_assert(_isPlain<HyperReal<double,Lanes<double,4> >, double, Lanes<double,4> >()
+    && sizeof(Lanes<double,4>) == 4*sizeof(double), "Lanes tangents must be plain data");
 
   /* Derivatives of functions from std::math library */
 
@@ -165,6 +579,43 @@ namespace Gkyl {
     // sign of value
     template <typename T>
     int sgn(T val) { return (T(0) < val) - (val < T(0)); }
+
+    // x^n by repeated squaring
+    template <typename T>
+    T _powi(T x, long n) {
+      unsigned long m = n < 0 ? -(unsigned long) n : n;
+      T r(1);
+      while (m) {
+        if (m & 1) r *= x;
+        m >>= 1;
+        if (m) x *= x;
+      }
+      return n < 0 ? T(1)/r : r;
+    }
+
+    // x^N for N known at compile time: the squarings are unrolled
+    template <int N>
+    struct _pown {
+        template <typename T>
+        constexpr static T g(const T& x) {
+          if constexpr (N < 0) return T(1)/_pown<-N>::g(x);
+          else if constexpr (N == 0) return T(1);
+          else if constexpr (N == 1) return x;
+          else {
+            T h = _pown<N/2>::g(x);
+            if constexpr (N%2 == 1) return h*h*x;
+            else return h*h;
+          }
+        }
+    };
+
+    // sign of each lane
+    template <typename T, int N, int A>
+    Lanes<T,N,A> sgn(const Lanes<T,N,A>& x) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = sgn(x[i]);
+      return r;
+    }
     
     // this default private struct supplies methods for use with POD
     // types (double and float)
@@ -185,90 +636,239 @@ namespace Gkyl {
         static T abs(const T& x) { return std::abs(x); }
         static T floor(const T& x) { return std::floor(x); }
         static T ceil(const T& x) { return std::ceil(x); }
+        static T cbrt(const T& x) { return std::cbrt(x); }
+        static T pow(const T& x, const T& y) { return std::pow(x, y); }
+        static T powi(const T& x, long n) { return _powi(x, n); }
+        template <int N>
+        constexpr static T pown(const T& x) { return _pown<N>::g(x); }
+        static T hypot(const T& x, const T& y) { return std::hypot(x, y); }
+        static T atan2(const T& y, const T& x) { return std::atan2(y, x); }
     };
-    
+
+    /* Partial derivatives of p = x^y. With respect to x, y x^(y-1),
+     * not computed as y p/x at x = 0. With respect to y, p log x, zero
+     * where p is (the limit at x = 0). Lanes are done one at a time */
+    template <typename T>
+    inline T _powDx(const T& x, const T& y, const T& p) {
+      return x != 0 ? y*p/x : y*_m<T>::pow(x, y-1);
+    }
+    template <typename T, int N, int A>
+    inline Lanes<T,N,A> _powDx(const Lanes<T,N,A>& x, const Lanes<T,N,A>& y, const Lanes<T,N,A>& p) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = _powDx(x[i], y[i], p[i]);
+      return r;
+    }
+    template <typename T>
+    inline T _powDy(const T& x, const T& p) {
+      return p != 0 ? p*_m<T>::log(x) : T(0);
+    }
+    template <typename T, int N, int A>
+    inline Lanes<T,N,A> _powDy(const Lanes<T,N,A>& x, const Lanes<T,N,A>& p) {
+      Lanes<T,N,A> r;
+      for (int i=0; i<N; ++i) r[i] = _powDy(x[i], p[i]);
+      return r;
+    }
+
     // specialization to HyperReal number
     template <typename RT, typename AT>
     struct _m<HyperReal<RT,AT> > {
         
         static HyperReal<RT,AT> sqrt(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          double y0 = std::sqrt(x0);
-          return HyperReal<RT,AT>(y0, 0.5*x1/y0);
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          RT y0 = _m<RT>::sqrt(x0);
+          return HyperReal<RT,AT>(y0, x1*_d<AT>(1/(2*y0)));
         }
         
         static HyperReal<RT,AT> cos(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::cos(x0), -x1*std::sin(x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::cos(x0), x1*_d<AT>(-_m<RT>::sin(x0)));
         }
         
         static HyperReal<RT,AT> sin(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::sin(x0), x1*std::cos(x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::sin(x0), x1*_d<AT>(_m<RT>::cos(x0)));
         }
 
         static HyperReal<RT,AT> tan(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          double tx0 = std::tan(x0);
-          return HyperReal<RT,AT>(tx0, x1*(1+tx0*tx0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          RT tx0 = _m<RT>::tan(x0);
+          return HyperReal<RT,AT>(tx0, x1*_d<AT>(_fma(tx0, tx0, RT(1))));
         }
 
         static HyperReal<RT,AT> asin(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::asin(x0), x1/std::sqrt(1-x0*x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::asin(x0), x1*_d<AT>(1/_m<RT>::sqrt(_fma(-x0, x0, RT(1)))));
         }
 
         static HyperReal<RT,AT> acos(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::acos(x0), -x1/std::sqrt(1-x0*x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::acos(x0), x1*_d<AT>(-1/_m<RT>::sqrt(_fma(-x0, x0, RT(1)))));
         }
 
         static HyperReal<RT,AT> atan(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::atan(x0), x1/(1+x0*x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::atan(x0), x1*_d<AT>(1/_fma(x0, x0, RT(1))));
         }
 
         static HyperReal<RT,AT> sinh(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::sinh(x0), x1*std::cosh(x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::sinh(x0), x1*_d<AT>(_m<RT>::cosh(x0)));
         }
 
         static HyperReal<RT,AT> cosh(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::cosh(x0), x1*std::sinh(x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::cosh(x0), x1*_d<AT>(_m<RT>::sinh(x0)));
         }
 
         static HyperReal<RT,AT> tanh(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          double tx0 = std::tanh(x0);
-          return HyperReal<RT,AT>(tx0, x1*(1-tx0*tx0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          RT tx0 = _m<RT>::tanh(x0);
+          return HyperReal<RT,AT>(tx0, x1*_d<AT>(_fma(-tx0, tx0, RT(1))));
         }
 
         static HyperReal<RT,AT> exp(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          double ex0 = std::exp(x0);
-          return HyperReal<RT,AT>(ex0, x1*ex0);
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          RT ex0 = _m<RT>::exp(x0);
+          return HyperReal<RT,AT>(ex0, x1*_d<AT>(ex0));
         }
 
         static HyperReal<RT,AT> log(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::log(x0), x1/x0);
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::log(x0), x1*_d<AT>(1/x0));
         }
 
         static HyperReal<RT,AT> abs(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::abs(x0), x1*sgn(x0));
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::abs(x0), x1*sgn(x0));
         }
 
         static HyperReal<RT,AT> floor(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::floor(x0), 0.0);
+          RT x0 = x.real();
+          return HyperReal<RT,AT>(_m<RT>::floor(x0), AT(0));
         }
 
         static HyperReal<RT,AT> ceil(const HyperReal<RT,AT>& x) {
-          RT x0 = x.real(); AT x1 = x.inf();
-          return HyperReal<RT,AT>(std::ceil(x0), 0.0);
+          RT x0 = x.real();
+          return HyperReal<RT,AT>(_m<RT>::ceil(x0), AT(0));
+        }
+
+        static HyperReal<RT,AT> cbrt(const HyperReal<RT,AT>& x) {
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          RT y0 = _m<RT>::cbrt(x0);
+          return HyperReal<RT,AT>(y0, x1*_d<AT>(1/(3*y0*y0)));
+        }
+
+        // x^n: x^(n-1) is shared by value and derivative
+        static HyperReal<RT,AT> powi(const HyperReal<RT,AT>& x, long n) {
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          if (n == 0) return HyperReal<RT,AT>(RT(1), AT(0));
+          if (n < 0) {
+            RT y0 = 1/_m<RT>::powi(x0, -n);
+            return HyperReal<RT,AT>(y0, x1*_d<AT>(RT(n)*y0/x0));
+          }
+          RT pm1 = _m<RT>::powi(x0, n-1);
+          return HyperReal<RT,AT>(pm1*x0, x1*_d<AT>(RT(n)*pm1));
         }
+
+        // x^N for compile-time N: as powi, with the exponent known
+        template <int N>
+        constexpr static HyperReal<RT,AT> pown(const HyperReal<RT,AT>& x) {
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          if constexpr (N == 0) return HyperReal<RT,AT>(RT(1), AT(0));
+          else if constexpr (N < 0) {
+            RT y0 = _m<RT>::template pown<N>(x0);
+            return HyperReal<RT,AT>(y0, x1*_d<AT>(RT(N)*y0/x0));
+          }
+          else {
+            RT pm1 = _m<RT>::template pown<N-1>(x0);
+            return HyperReal<RT,AT>(pm1*x0, x1*_d<AT>(RT(N)*pm1));
+          }
+        }
+
+        // x^p for passive p: x^(p-1) is not computed as x^p/x, which
+        // is wrong at x = 0
+        static HyperReal<RT,AT> pow(const HyperReal<RT,AT>& x, const RT& p) {
+          RT x0 = x.real(); const AT& x1 = x.inf();
+          return HyperReal<RT,AT>(_m<RT>::pow(x0, p), x1*_d<AT>(p*_m<RT>::pow(x0, p-1)));
+        }
+
+        // a^y for passive a. The log a term is skipped if y is
+        // constant, so that a < 0 gives a zero rather than NaN
+        // derivative
+        static HyperReal<RT,AT> pow(const RT& a, const HyperReal<RT,AT>& y) {
+          RT y0 = y.real(); const AT& y1 = y.inf();
+          RT p0 = _m<RT>::pow(a, y0);
+          if (_isZero(y1)) return HyperReal<RT,AT>(p0, y1);
+          return HyperReal<RT,AT>(p0, y1*_d<AT>(_powDy(a, p0)));
+        }
+
+        // x^y = exp(y log x): x^y is shared by both terms. The log x
+        // term is skipped if y is constant, so that any x for which
+        // x^y is defined has a derivative
+        static HyperReal<RT,AT> pow(const HyperReal<RT,AT>& x, const HyperReal<RT,AT>& y) {
+          RT x0 = x.real(), y0 = y.real(); const AT& x1 = x.inf(), &y1 = y.inf();
+          RT p0 = _m<RT>::pow(x0, y0);
+          RT dx = _powDx(x0, y0, p0);
+          if (_isZero(y1)) return HyperReal<RT,AT>(p0, x1*_d<AT>(dx));
+          return HyperReal<RT,AT>(p0, _fma2(x1, _d<AT>(dx), y1, _d<AT>(_powDy(x0, p0))));
+        }
+
+        static HyperReal<RT,AT> hypot(const HyperReal<RT,AT>& x, const HyperReal<RT,AT>& y) {
+          RT x0 = x.real(), y0 = y.real(); const AT& x1 = x.inf(), &y1 = y.inf();
+          RT h0 = _m<RT>::hypot(x0, y0), r = 1/h0;
+          return HyperReal<RT,AT>(h0, _fma2(x1, _d<AT>(x0*r), y1, _d<AT>(y0*r)));
+        }
+
+        static HyperReal<RT,AT> atan2(const HyperReal<RT,AT>& y, const HyperReal<RT,AT>& x) {
+          RT x0 = x.real(), y0 = y.real(); const AT& x1 = x.inf(), &y1 = y.inf();
+          RT r = 1/_fma(x0, x0, y0*y0);
+          return HyperReal<RT,AT>(_m<RT>::atan2(y0, x0), _fma2(y1, _d<AT>(x0*r), x1, _d<AT>(-y0*r)));
+        }
+    };
+
+    // specialization to Lanes: functions are applied to each lane
+    template <typename T, int N, int A>
+    struct _m<Lanes<T,N,A> > {
+
+        template <typename F>
+        static Lanes<T,N,A> map(const Lanes<T,N,A>& x, F f) {
+          Lanes<T,N,A> r;
+          for (int i=0; i<N; ++i) r[i] = f(x[i]);
+          return r;
+        }
+        template <typename F>
+        static Lanes<T,N,A> map(const Lanes<T,N,A>& x, const Lanes<T,N,A>& y, F f) {
+          Lanes<T,N,A> r;
+          for (int i=0; i<N; ++i) r[i] = f(x[i], y[i]);
+          return r;
+        }
+
+        static Lanes<T,N,A> sqrt(const Lanes<T,N,A>& x) { return map(x, _m<T>::sqrt); }
+        static Lanes<T,N,A> cos(const Lanes<T,N,A>& x) { return map(x, _m<T>::cos); }
+        static Lanes<T,N,A> sin(const Lanes<T,N,A>& x) { return map(x, _m<T>::sin); }
+        static Lanes<T,N,A> tan(const Lanes<T,N,A>& x) { return map(x, _m<T>::tan); }
+        static Lanes<T,N,A> asin(const Lanes<T,N,A>& x) { return map(x, _m<T>::asin); }
+        static Lanes<T,N,A> acos(const Lanes<T,N,A>& x) { return map(x, _m<T>::acos); }
+        static Lanes<T,N,A> atan(const Lanes<T,N,A>& x) { return map(x, _m<T>::atan); }
+        static Lanes<T,N,A> sinh(const Lanes<T,N,A>& x) { return map(x, _m<T>::sinh); }
+        static Lanes<T,N,A> cosh(const Lanes<T,N,A>& x) { return map(x, _m<T>::cosh); }
+        static Lanes<T,N,A> tanh(const Lanes<T,N,A>& x) { return map(x, _m<T>::tanh); }
+        static Lanes<T,N,A> exp(const Lanes<T,N,A>& x) { return map(x, _m<T>::exp); }
+        static Lanes<T,N,A> log(const Lanes<T,N,A>& x) { return map(x, _m<T>::log); }
+        static Lanes<T,N,A> abs(const Lanes<T,N,A>& x) { return map(x, _m<T>::abs); }
+        static Lanes<T,N,A> floor(const Lanes<T,N,A>& x) { return map(x, _m<T>::floor); }
+        static Lanes<T,N,A> ceil(const Lanes<T,N,A>& x) { return map(x, _m<T>::ceil); }
+        static Lanes<T,N,A> cbrt(const Lanes<T,N,A>& x) { return map(x, _m<T>::cbrt); }
+        static Lanes<T,N,A> pow(const Lanes<T,N,A>& x, const Lanes<T,N,A>& y) { return map(x, y, _m<T>::pow); }
+        static Lanes<T,N,A> powi(const Lanes<T,N,A>& x, long n) {
+          return map(x, [n](const T& xi) { return _m<T>::powi(xi, n); });
+        }
+        template <int M>
+        static Lanes<T,N,A> pown(const Lanes<T,N,A>& x) {
+          return map(x, [](const T& xi) { return _m<T>::template pown<M>(xi); });
+        }
+        static Lanes<T,N,A> hypot(const Lanes<T,N,A>& x, const Lanes<T,N,A>& y) { return map(x, y, _m<T>::hypot); }
+        static Lanes<T,N,A> atan2(const Lanes<T,N,A>& y, const Lanes<T,N,A>& x) { return map(y, x, _m<T>::atan2); }
     };
   }
 
@@ -288,4 +888,70 @@ namespace Gkyl {
   template <typename T> inline T abs(const T& x) { return _m<T>::abs(x); }
   template <typename T> inline T floor(const T& x) { return _m<T>::floor(x); }
   template <typename T> inline T ceil(const T& x) { return _m<T>::ceil(x); }
+  template <typename T> inline T cbrt(const T& x) { return _m<T>::cbrt(x); }
+
+  // Powers. The exponent can be an integer (computed by repeated
+  // squaring), a passive real number or of the same type as the base;
+  // the base can be passive if the exponent is active
+  template <typename T, typename E>
+  inline typename std::enable_if<std::is_integral<E>::value, T>::type
+  pow(const T& x, E n) { return _m<T>::powi(x, n); }
+  template <typename T>
+  inline T pow(const T& x, const T& y) { return _m<T>::pow(x, y); }
+  template <typename T, typename P>
+  inline typename std::enable_if<!std::is_same<T,P>::value && std::is_floating_point<P>::value, T>::type
+  pow(const T& x, const P& p) { return _m<T>::pow(x, p); }
+  template <typename P, typename T>
+  inline typename std::enable_if<std::is_arithmetic<P>::value && !std::is_arithmetic<T>::value, T>::type
+  pow(const P& a, const T& y) { return _m<T>::pow(a, y); }
+
+  // x^N for integer N known at compile time, e.g. pow<3>(x): the
+  // multiplications are unrolled, and the derivative is N x^(N-1) dx
+  template <int N, typename T>
+  constexpr inline T pow(const T& x) { return _m<T>::template pown<N>(x); }
+
+  // sqrt(x^2+y^2) and atan(y/x) in the correct quadrant. One argument
+  // can be passive
+  template <typename T> inline T hypot(const T& x, const T& y) { return _m<T>::hypot(x, y); }
+  template <typename T, typename P>
+  inline typename std::enable_if<!std::is_arithmetic<T>::value && std::is_arithmetic<P>::value, T>::type
+  hypot(const T& x, const P& y) { return _m<T>::hypot(x, T(y)); }
+  template <typename P, typename T>
+  inline typename std::enable_if<std::is_arithmetic<P>::value && !std::is_arithmetic<T>::value, T>::type
+  hypot(const P& x, const T& y) { return _m<T>::hypot(T(x), y); }
+
+  template <typename T> inline T atan2(const T& y, const T& x) { return _m<T>::atan2(y, x); }
+  template <typename T, typename P>
+  inline typename std::enable_if<!std::is_arithmetic<T>::value && std::is_arithmetic<P>::value, T>::type
+  atan2(const T& y, const P& x) { return _m<T>::atan2(y, T(x)); }
+  template <typename P, typename T>
+  inline typename std::enable_if<std::is_arithmetic<P>::value && !std::is_arithmetic<T>::value, T>::type
+  atan2(const P& y, const T& x) { return _m<T>::atan2(T(y), x); }
+
+  /* Polynomial c[0] + c[1]*x + ... + c[N-1]*x^(N-1) using Horner's
+   * rule. This (and ratval) can be used in constant expressions, so
+   * with a constexpr HyperReal x the derivative of a coefficient
+   * formula is computed at compile time */
+  template <typename T, typename C, std::size_t N>
+  constexpr inline T polyval(const C (&c)[N], const T& x) {
+    T s(c[N-1]);
+    for (std::size_t i=N-1; i>0; --i) s = s*x+c[i-1];
+    return s;
+  }
+  template <typename T, typename C, std::size_t N>
+  constexpr inline T polyval(const std::array<C,N>& c, const T& x) {
+    T s(c[N-1]);
+    for (std::size_t i=N-1; i>0; --i) s = s*x+c[i-1];
+    return s;
+  }
+
+  /* Rational function p(x)/q(x), coefficients ordered as in polyval */
+  template <typename T, typename C, std::size_t NP, std::size_t NQ>
+  constexpr inline T ratval(const C (&p)[NP], const C (&q)[NQ], const T& x) {
+    return polyval(p, x)/polyval(q, x);
+  }
+  template <typename T, typename C, std::size_t NP, std::size_t NQ>
+  constexpr inline T ratval(const std::array<C,NP>& p, const std::array<C,NQ>& q, const T& x) {
+    return polyval(p, x)/polyval(q, x);
+  }
 }
@@ -0,0 +1,251 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Views of separate value and tangent arrays as HyperReal numbers
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace Gkyl {
+
+  /* Reference to the HyperReal number whose real part is r and whose
+   * infinitesimal part is i, held in separate arrays. Reads give a
+   * HyperReal, and assignments write both parts back */
+  template <typename RT, typename AT=RT>
+  class HyperRef {
+    public:
+      HyperRef(RT& r, AT& i) : r(r), i(i) { }
+
+      // number referred to
+      operator HyperReal<RT,AT>() const { return HyperReal<RT,AT>(r, i); }
+      HyperReal<RT,AT> get() const { return *this; }
+
+      // real and infinitesimal parts, in the arrays
+      RT& real() const { return r; }
+      AT& inf() const { return i; }
+
+      // assignment = writes the number, and does not rebind
+      HyperRef& operator=(const HyperReal<RT,AT>& x) {
+        r = x.real(); i = x.inf();
+        return *this;
+      }
+      HyperRef& operator=(const HyperRef& x) { return *this = x.get(); }
+
+      // compound assignment +=, -=, *=, /=
+      HyperRef& operator+=(const HyperReal<RT,AT>& y) { HyperReal<RT,AT> x(*this); x += y; return *this = x; }
+      HyperRef& operator-=(const HyperReal<RT,AT>& y) { HyperReal<RT,AT> x(*this); x -= y; return *this = x; }
+      HyperRef& operator*=(const HyperReal<RT,AT>& y) { HyperReal<RT,AT> x(*this); x *= y; return *this = x; }
+      HyperRef& operator/=(const HyperReal<RT,AT>& y) { HyperReal<RT,AT> x(*this); x /= y; return *this = x; }
+
+      // binary +, -, *, / with numbers, passive values and other
+      // references, all read as the numbers they refer to
+      template <typename T>
+      friend auto operator+(const HyperRef& x, const T& y) -> decltype(x.get()+y) { return x.get()+y; }
+      template <typename T>
+      friend auto operator+(const T& x, const HyperRef& y) -> decltype(x+y.get()) { return x+y.get(); }
+      friend HyperReal<RT,AT> operator+(const HyperRef& x, const HyperRef& y) { return x.get()+y.get(); }
+      template <typename T>
+      friend auto operator-(const HyperRef& x, const T& y) -> decltype(x.get()-y) { return x.get()-y; }
+      template <typename T>
+      friend auto operator-(const T& x, const HyperRef& y) -> decltype(x-y.get()) { return x-y.get(); }
+      friend HyperReal<RT,AT> operator-(const HyperRef& x, const HyperRef& y) { return x.get()-y.get(); }
+      template <typename T>
+      friend auto operator*(const HyperRef& x, const T& y) -> decltype(x.get()*y) { return x.get()*y; }
+      template <typename T>
+      friend auto operator*(const T& x, const HyperRef& y) -> decltype(x*y.get()) { return x*y.get(); }
+      friend HyperReal<RT,AT> operator*(const HyperRef& x, const HyperRef& y) { return x.get()*y.get(); }
+      template <typename T>
+      friend auto operator/(const HyperRef& x, const T& y) -> decltype(x.get()/y) { return x.get()/y; }
+      template <typename T>
+      friend auto operator/(const T& x, const HyperRef& y) -> decltype(x/y.get()) { return x/y.get(); }
+      friend HyperReal<RT,AT> operator/(const HyperRef& x, const HyperRef& y) { return x.get()/y.get(); }
+
+      // unary -, +
+      HyperReal<RT,AT> operator-() const { return -get(); }
+      HyperReal<RT,AT> operator+() const { return get(); }
+
+    private:
+      RT& r; /* Real part */
+      AT& i; /* Infinitesimal part */
+  };
+
+  // The parts of a reference are those of the number it refers to, so
+  // references can be compared, and mixed with numbers in arithmetic
+  namespace {
+    template <typename RT, typename AT>
+    struct _R<HyperRef<RT, AT> > {
+        static RT g(const HyperRef<RT, AT>& r) { return r.real(); }
+    };
+    template <typename RT, typename AT>
+    struct _I<HyperRef<RT, AT> > {
+        static const AT& g(const HyperRef<RT, AT>& r) { return r.inf(); }
+    };
+    template <typename RT, typename AT>
+    struct _A<HyperRef<RT, AT> > {
+        static constexpr bool value = true;
+    };
+  }
+
+  // Math functions of references are those of the numbers referred to
+  template <typename RT, typename AT> inline HyperReal<RT,AT> sqrt(const HyperRef<RT,AT>& x) { return sqrt(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> cos(const HyperRef<RT,AT>& x) { return cos(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> sin(const HyperRef<RT,AT>& x) { return sin(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> tan(const HyperRef<RT,AT>& x) { return tan(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> asin(const HyperRef<RT,AT>& x) { return asin(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> acos(const HyperRef<RT,AT>& x) { return acos(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> atan(const HyperRef<RT,AT>& x) { return atan(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> sinh(const HyperRef<RT,AT>& x) { return sinh(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> cosh(const HyperRef<RT,AT>& x) { return cosh(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> tanh(const HyperRef<RT,AT>& x) { return tanh(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> exp(const HyperRef<RT,AT>& x) { return exp(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> log(const HyperRef<RT,AT>& x) { return log(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> abs(const HyperRef<RT,AT>& x) { return abs(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> floor(const HyperRef<RT,AT>& x) { return floor(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> ceil(const HyperRef<RT,AT>& x) { return ceil(x.get()); }
+  template <typename RT, typename AT> inline HyperReal<RT,AT> cbrt(const HyperRef<RT,AT>& x) { return cbrt(x.get()); }
+  template <int N, typename RT, typename AT> inline HyperReal<RT,AT> pow(const HyperRef<RT,AT>& x) { return pow<N>(x.get()); }
+
+  // Functions of two arguments, either of which can be a reference
+  template <typename RT, typename AT, typename E>
+  inline auto pow(const HyperRef<RT,AT>& x, const E& y) -> decltype(pow(x.get(), y)) { return pow(x.get(), y); }
+  template <typename P, typename RT, typename AT>
+  inline auto pow(const P& x, const HyperRef<RT,AT>& y) -> decltype(pow(x, y.get())) { return pow(x, y.get()); }
+  template <typename RT, typename AT>
+  inline HyperReal<RT,AT> pow(const HyperRef<RT,AT>& x, const HyperRef<RT,AT>& y) { return pow(x.get(), y.get()); }
+  template <typename RT, typename AT, typename P>
+  inline auto hypot(const HyperRef<RT,AT>& x, const P& y) -> decltype(hypot(x.get(), y)) { return hypot(x.get(), y); }
+  template <typename P, typename RT, typename AT>
+  inline auto hypot(const P& x, const HyperRef<RT,AT>& y) -> decltype(hypot(x, y.get())) { return hypot(x, y.get()); }
+  template <typename RT, typename AT>
+  inline HyperReal<RT,AT> hypot(const HyperRef<RT,AT>& x, const HyperRef<RT,AT>& y) { return hypot(x.get(), y.get()); }
+  template <typename RT, typename AT, typename P>
+  inline auto atan2(const HyperRef<RT,AT>& y, const P& x) -> decltype(atan2(y.get(), x)) { return atan2(y.get(), x); }
+  template <typename P, typename RT, typename AT>
+  inline auto atan2(const P& y, const HyperRef<RT,AT>& x) -> decltype(atan2(y, x.get())) { return atan2(y, x.get()); }
+  template <typename RT, typename AT>
+  inline HyperReal<RT,AT> atan2(const HyperRef<RT,AT>& y, const HyperRef<RT,AT>& x) { return atan2(y.get(), x.get()); }
+
+  /* Random-access iterator over a view V, whose elements are what
+   * V::operator[] returns: HyperRef proxies for a HyperView, HyperReal
+   * numbers for a ConstHyperView. As for other proxy iterators, there
+   * is no operator-> */
+  template <typename V>
+  class HyperViewIterator {
+    public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef typename V::value_type value_type;
+      typedef decltype(std::declval<const V&>()[0]) reference;
+      typedef void pointer;
+      typedef std::ptrdiff_t difference_type;
+
+      HyperViewIterator() : v(nullptr, nullptr, 0), k(0) { }
+      HyperViewIterator(const V& v, std::size_t k) : v(v), k(k) { }
+
+      // element, and element d places on
+      reference operator*() const { return v[k]; }
+      reference operator[](difference_type d) const { return v[k+d]; }
+
+      // increment and decrement
+      HyperViewIterator& operator++() { ++k; return *this; }
+      HyperViewIterator& operator--() { --k; return *this; }
+      HyperViewIterator operator++(int) { HyperViewIterator r(*this); ++k; return r; }
+      HyperViewIterator operator--(int) { HyperViewIterator r(*this); --k; return r; }
+      HyperViewIterator& operator+=(difference_type d) { k += d; return *this; }
+      HyperViewIterator& operator-=(difference_type d) { k -= d; return *this; }
+
+      friend HyperViewIterator operator+(HyperViewIterator i, difference_type d) { return i += d; }
+      friend HyperViewIterator operator+(difference_type d, HyperViewIterator i) { return i += d; }
+      friend HyperViewIterator operator-(HyperViewIterator i, difference_type d) { return i -= d; }
+      friend difference_type operator-(const HyperViewIterator& i, const HyperViewIterator& j) {
+        return difference_type(i.k) - difference_type(j.k);
+      }
+
+      // iterators of the same view compare by position
+      friend bool operator==(const HyperViewIterator& i, const HyperViewIterator& j) { return i.k == j.k; }
+      friend bool operator!=(const HyperViewIterator& i, const HyperViewIterator& j) { return i.k != j.k; }
+      friend bool operator<(const HyperViewIterator& i, const HyperViewIterator& j) { return i.k < j.k; }
+      friend bool operator>(const HyperViewIterator& i, const HyperViewIterator& j) { return i.k > j.k; }
+      friend bool operator<=(const HyperViewIterator& i, const HyperViewIterator& j) { return i.k <= j.k; }
+      friend bool operator>=(const HyperViewIterator& i, const HyperViewIterator& j) { return i.k >= j.k; }
+
+    private:
+      V v; /* View iterated over */
+      std::size_t k; /* Index of element */
+  };
+
+  /* View of n HyperReal numbers stored as an array of real parts and
+   * an array of infinitesimal parts (structure of arrays), such as
+   * values and tangents owned by a solver. Nothing is copied: element
+   * k is a HyperRef to val[k] and tan[k]. Like a span, the view does
+   * not own the arrays, and a const view can still write to them */
+  template <typename RT, typename AT=RT>
+  class HyperView {
+    public:
+      typedef HyperReal<RT,AT> value_type;
+      typedef HyperViewIterator<HyperView> iterator;
+
+      HyperView(RT *val, AT *tan, std::size_t n) : vp(val), tp(tan), n(n) { }
+
+      // number of elements
+      std::size_t size() const { return n; }
+      // arrays of real and infinitesimal parts
+      RT* values() const { return vp; }
+      AT* tangents() const { return tp; }
+
+      // element k
+      HyperRef<RT,AT> operator[](std::size_t k) const { return HyperRef<RT,AT>(vp[k], tp[k]); }
+      // iterators over the elements, for range-for and algorithms
+      iterator begin() const { return iterator(*this, 0); }
+      iterator end() const { return iterator(*this, n); }
+
+      // view of elements [b, e)
+      HyperView sub(std::size_t b, std::size_t e) const { return HyperView(vp+b, tp+b, e-b); }
+
+    private:
+      RT *vp; /* Real parts */
+      AT *tp; /* Infinitesimal parts */
+      std::size_t n; /* Number of elements */
+  };
+
+  /* Read-only view of n HyperReal numbers stored as separate arrays:
+   * element k is the HyperReal made from val[k] and tan[k] */
+  template <typename RT, typename AT=RT>
+  class ConstHyperView {
+    public:
+      typedef HyperReal<RT,AT> value_type;
+      typedef HyperViewIterator<ConstHyperView> iterator;
+
+      ConstHyperView(const RT *val, const AT *tan, std::size_t n) : vp(val), tp(tan), n(n) { }
+      ConstHyperView(const HyperView<RT,AT>& v) : ConstHyperView(v.values(), v.tangents(), v.size()) { }
+
+      // number of elements
+      std::size_t size() const { return n; }
+      // arrays of real and infinitesimal parts
+      const RT* values() const { return vp; }
+      const AT* tangents() const { return tp; }
+
+      // element k
+      HyperReal<RT,AT> operator[](std::size_t k) const { return HyperReal<RT,AT>(vp[k], tp[k]); }
+      // iterators over the elements
+      iterator begin() const { return iterator(*this, 0); }
+      iterator end() const { return iterator(*this, n); }
+
+      // view of elements [b, e)
+      ConstHyperView sub(std::size_t b, std::size_t e) const { return ConstHyperView(vp+b, tp+b, e-b); }
+
+    private:
+      const RT *vp; /* Real parts */
+      const AT *tp; /* Infinitesimal parts */
+      std::size_t n; /* Number of elements */
+  };
+}
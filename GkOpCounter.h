@@ -0,0 +1,212 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Operation counting number type, for instrumenting primal and
+// HyperReal computations
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace Gkyl {
+
+  /* Counts of operations on Counted numbers */
+  struct OpCounts {
+      // math functions that are counted separately
+      enum Func { SQRT, COS, SIN, TAN, ASIN, ACOS, ATAN, SINH, COSH, TANH,
+                  EXP, LOG, ABS, FLOOR, CEIL, CBRT, POW, HYPOT, ATAN2, NFUNC };
+
+      long add = 0; /* Additions, subtractions and negations */
+      long mul = 0; /* Multiplications */
+      long div = 0; /* Divisions */
+      long cmp = 0; /* Comparisons */
+      long temps = 0; /* Numbers constructed (including copies) */
+      long func[NFUNC] = { }; /* Calls to each math function */
+
+      // total number of floating-point operations
+      long flops() const { return add+mul+div; }
+      // total number of math function calls
+      long funcs() const {
+        long n = 0;
+        for (int i=0; i<NFUNC; ++i) n += func[i];
+        return n;
+      }
+
+      // name of function
+      static const char* funcName(int f) {
+        static const char* names[NFUNC] = {
+          "sqrt", "cos", "sin", "tan", "asin", "acos", "atan", "sinh", "cosh",
+          "tanh", "exp", "log", "abs", "floor", "ceil", "cbrt", "pow", "hypot", "atan2"
+        };
+        return names[f];
+      }
+  };
+
+  /* Per-thread registry of operation counts, one entry per call-site
+   * (named by an OpCountScope). Counts outside any scope are
+   * attributed to the site "(none)" */
+  class OpCounter {
+    public:
+      // counts of the current call-site
+      static OpCounts& current() { return *state().cur; }
+
+      // counts of named call-site
+      static OpCounts& site(const std::string& name) { return state().sites[name]; }
+
+      // clear all counts
+      static void reset() {
+        for (auto& s : state().sites) s.second = OpCounts();
+      }
+
+      // write table of counts per call-site
+      static void report(std::ostream& out) {
+        out << std::left << std::setw(20) << "site" << std::right
+            << std::setw(10) << "add" << std::setw(10) << "mul" << std::setw(10) << "div"
+            << std::setw(10) << "cmp" << std::setw(10) << "funcs" << std::setw(10) << "temps"
+            << std::endl;
+        for (const auto& s : state().sites) {
+          const OpCounts& c = s.second;
+          if (c.flops()+c.cmp+c.funcs()+c.temps == 0) continue;
+          out << std::left << std::setw(20) << s.first << std::right
+              << std::setw(10) << c.add << std::setw(10) << c.mul << std::setw(10) << c.div
+              << std::setw(10) << c.cmp << std::setw(10) << c.funcs() << std::setw(10) << c.temps;
+          for (int f=0; f<OpCounts::NFUNC; ++f)
+            if (c.func[f] > 0) out << " " << OpCounts::funcName(f) << ":" << c.func[f];
+          out << std::endl;
+        }
+      }
+
+    private:
+      friend class OpCountScope;
+
+      struct State {
+          State() : cur(&sites["(none)"]) { }
+          std::map<std::string, OpCounts> sites; /* Counts of each site */
+          OpCounts *cur; /* Counts of current site */
+      };
+
+      static State& state() {
+        static thread_local State s;
+        return s;
+      }
+  };
+
+  /* Attributes operations on Counted numbers, in the lifetime of this
+   * object, to the call-site 'name'. Scopes can be nested, in which
+   * case the innermost scope gets the counts */
+  class OpCountScope {
+    public:
+      OpCountScope(const std::string& name) : prev(OpCounter::state().cur) {
+        OpCounter::state().cur = &OpCounter::state().sites[name];
+      }
+      ~OpCountScope() { OpCounter::state().cur = prev; }
+
+      OpCountScope(const OpCountScope&) = delete;
+      OpCountScope& operator=(const OpCountScope&) = delete;
+
+    private:
+      OpCounts *prev; /* Counts of enclosing site */
+  };
+
+  /* Number of type T that counts operations performed on it. Use as
+   * Counted<double> to instrument a primal computation, or as the
+   * real and infinitesimal type of a HyperReal,
+   * HyperReal<Counted<double>>, to instrument its derivative
+   * computation. There is no overhead unless this type is used */
+  template <typename T>
+  class Counted {
+    public:
+      // various ctors
+      Counted() : v(0) { ++OpCounter::current().temps; }
+      Counted(const T& v) : v(v) { ++OpCounter::current().temps; }
+      Counted(const Counted& c) : v(c.v) { ++OpCounter::current().temps; }
+
+      Counted& operator=(const Counted& c) = default;
+
+      // value of number
+      T value() const { return v; }
+
+      // compound assignment +=, -=, *=, /=
+      Counted& operator+=(const Counted& y) { ++OpCounter::current().add; v += y.v; return *this; }
+      Counted& operator-=(const Counted& y) { ++OpCounter::current().add; v -= y.v; return *this; }
+      Counted& operator*=(const Counted& y) { ++OpCounter::current().mul; v *= y.v; return *this; }
+      Counted& operator/=(const Counted& y) { ++OpCounter::current().div; v /= y.v; return *this; }
+
+      // binary +, -, *, /
+      friend Counted operator+(const Counted& x, const Counted& y) { ++OpCounter::current().add; return Counted(x.v+y.v); }
+      friend Counted operator-(const Counted& x, const Counted& y) { ++OpCounter::current().add; return Counted(x.v-y.v); }
+      friend Counted operator*(const Counted& x, const Counted& y) { ++OpCounter::current().mul; return Counted(x.v*y.v); }
+      friend Counted operator/(const Counted& x, const Counted& y) { ++OpCounter::current().div; return Counted(x.v/y.v); }
+
+      // unary -, +
+      Counted operator-() const { ++OpCounter::current().add; return Counted(-v); }
+      Counted operator+() const { return *this; }
+
+      // relational and equality operators
+      friend bool operator<(const Counted& x, const Counted& y) { ++OpCounter::current().cmp; return x.v < y.v; }
+      friend bool operator>(const Counted& x, const Counted& y) { ++OpCounter::current().cmp; return x.v > y.v; }
+      friend bool operator<=(const Counted& x, const Counted& y) { ++OpCounter::current().cmp; return x.v <= y.v; }
+      friend bool operator>=(const Counted& x, const Counted& y) { ++OpCounter::current().cmp; return x.v >= y.v; }
+      friend bool operator==(const Counted& x, const Counted& y) { ++OpCounter::current().cmp; return x.v == y.v; }
+      friend bool operator!=(const Counted& x, const Counted& y) { ++OpCounter::current().cmp; return x.v != y.v; }
+
+      // output
+      friend std::ostream& operator<<(std::ostream& out, const Counted& x) { return out << x.v; }
+
+    private:
+      T v; /* Value */
+  };
+
+  namespace {
+    // specialization to Counted: counts call and applies function to value
+    template <typename T>
+    struct _m<Counted<T> > {
+
+        static Counted<T> call(int fn, T (*g)(const T&), const Counted<T>& x) {
+          ++OpCounter::current().func[fn];
+          return Counted<T>(g(x.value()));
+        }
+        static Counted<T> call(int fn, T (*g)(const T&, const T&), const Counted<T>& x, const Counted<T>& y) {
+          ++OpCounter::current().func[fn];
+          return Counted<T>(g(x.value(), y.value()));
+        }
+
+        static Counted<T> sqrt(const Counted<T>& x) { return call(OpCounts::SQRT, _m<T>::sqrt, x); }
+        static Counted<T> cos(const Counted<T>& x) { return call(OpCounts::COS, _m<T>::cos, x); }
+        static Counted<T> sin(const Counted<T>& x) { return call(OpCounts::SIN, _m<T>::sin, x); }
+        static Counted<T> tan(const Counted<T>& x) { return call(OpCounts::TAN, _m<T>::tan, x); }
+        static Counted<T> asin(const Counted<T>& x) { return call(OpCounts::ASIN, _m<T>::asin, x); }
+        static Counted<T> acos(const Counted<T>& x) { return call(OpCounts::ACOS, _m<T>::acos, x); }
+        static Counted<T> atan(const Counted<T>& x) { return call(OpCounts::ATAN, _m<T>::atan, x); }
+        static Counted<T> sinh(const Counted<T>& x) { return call(OpCounts::SINH, _m<T>::sinh, x); }
+        static Counted<T> cosh(const Counted<T>& x) { return call(OpCounts::COSH, _m<T>::cosh, x); }
+        static Counted<T> tanh(const Counted<T>& x) { return call(OpCounts::TANH, _m<T>::tanh, x); }
+        static Counted<T> exp(const Counted<T>& x) { return call(OpCounts::EXP, _m<T>::exp, x); }
+        static Counted<T> log(const Counted<T>& x) { return call(OpCounts::LOG, _m<T>::log, x); }
+        static Counted<T> abs(const Counted<T>& x) { return call(OpCounts::ABS, _m<T>::abs, x); }
+        static Counted<T> floor(const Counted<T>& x) { return call(OpCounts::FLOOR, _m<T>::floor, x); }
+        static Counted<T> ceil(const Counted<T>& x) { return call(OpCounts::CEIL, _m<T>::ceil, x); }
+        static Counted<T> cbrt(const Counted<T>& x) { return call(OpCounts::CBRT, _m<T>::cbrt, x); }
+        static Counted<T> pow(const Counted<T>& x, const Counted<T>& y) { return call(OpCounts::POW, _m<T>::pow, x, y); }
+        static Counted<T> powi(const Counted<T>& x, long n) {
+          ++OpCounter::current().func[OpCounts::POW];
+          return Counted<T>(_m<T>::powi(x.value(), n));
+        }
+        // unrolled multiplications are counted individually
+        template <int N>
+        static Counted<T> pown(const Counted<T>& x) { return _pown<N>::g(x); }
+        static Counted<T> hypot(const Counted<T>& x, const Counted<T>& y) { return call(OpCounts::HYPOT, _m<T>::hypot, x, y); }
+        static Counted<T> atan2(const Counted<T>& y, const Counted<T>& x) { return call(OpCounts::ATAN2, _m<T>::atan2, y, x); }
+    };
+  }
+}
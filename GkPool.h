@@ -0,0 +1,129 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Per-thread pool of aligned memory blocks, for tangents whose size
+// is only known at run time, and an aligned allocator
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// std includes
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace Gkyl {
+
+  /* Pool of memory blocks of size align << c bytes, for c the size
+   * class, aligned to 'align' bytes (a cache line, and enough for any
+   * vector load). Released blocks are kept on per-thread free lists and
+   * handed out again, so temporaries do not call the heap once the
+   * pool is warm. No locks are needed as each thread has its own lists;
+   * a block can be released by a thread other than the one that got
+   * it, and then stays with that thread. So that a thread that only
+   * releases does not hoard blocks, each list holds at most maxBytes
+   * (but at least one block), and the rest go back to the heap, as do
+   * blocks released after the thread's lists are destroyed */
+  class BlockPool {
+    public:
+      // alignment, and size of smallest block, in bytes
+      static constexpr std::size_t align = 64;
+      // bytes held on the free list of each size class
+      static constexpr std::size_t maxBytes = std::size_t(1) << 22;
+
+      // size class of smallest block with at least 'bytes' bytes
+      static int sizeClass(std::size_t bytes) {
+        int c = 0;
+        while ((align << c) < bytes) ++c;
+        return c;
+      }
+      // size of blocks in size class, in bytes
+      static std::size_t blockSize(int c) { return align << c; }
+
+      // get block of size class c. This and release are kept out of
+      // line, so that callers whose pooled path is rare stay small
+      [[gnu::noinline]] static void* get(int c) {
+        Lists *l = lists();
+        if (!l || l->fl[c].empty()) return ::operator new(blockSize(c), std::align_val_t(align));
+        void *p = l->fl[c].back();
+        l->fl[c].pop_back();
+        return p;
+      }
+      // return block of size class c to pool
+      [[gnu::noinline]] static void release(void *p, int c) {
+        Lists *l = lists();
+        if (l && l->fl[c].size()*blockSize(c) < maxBytes) l->fl[c].push_back(p);
+        else ::operator delete(p, std::align_val_t(align));
+      }
+
+      // number of free blocks of size class c held by this thread
+      static std::size_t freeBlocks(int c) {
+        Lists *l = lists();
+        return l ? l->fl[c].size() : 0;
+      }
+
+    private:
+      struct Lists {
+          std::vector<void*> fl[40]; /* Free blocks of each size class */
+          ~Lists() {
+            gone() = true;
+            for (auto& l : fl)
+              for (void *p : l) ::operator delete(p, std::align_val_t(align));
+          }
+      };
+      // true once the lists of this thread are destroyed: thread_local
+      // numbers can outlive them. A bool has no destructor, so this can
+      // be read until the thread ends
+      static bool& gone() {
+        static thread_local bool g = false;
+        return g;
+      }
+      // lists of this thread, or null once destroyed
+      static Lists* lists() {
+        if (gone()) return nullptr;
+        static thread_local Lists l;
+        return &l;
+      }
+  };
+
+  /* Allocator of arrays that start on an A-byte boundary (by default
+   * a cache line), or the alignment of T if that is larger. Use for
+   * arrays of HyperReal numbers with vector tangents, e.g.
+   * std::vector<HyperReal<double,AlignedLanes<double,4>>,
+   * AlignedAllocator<HyperReal<double,AlignedLanes<double,4>>>>, so
+   * that the first tangent, and with it every other, starts on a
+   * vector boundary in the same cache line position */
+  template <typename T, std::size_t A = BlockPool::align>
+  class AlignedAllocator {
+    public:
+      typedef T value_type;
+      template <typename U>
+      struct rebind { typedef AlignedAllocator<U,A> other; };
+
+      // alignment of arrays, in bytes
+      static constexpr std::size_t alignment = A > alignof(T) ? A : alignof(T);
+
+      AlignedAllocator() = default;
+      template <typename U>
+      AlignedAllocator(const AlignedAllocator<U,A>&) { }
+
+      T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max()/sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t(alignment)));
+      }
+      void deallocate(T *p, std::size_t n) { ::operator delete(p, std::align_val_t(alignment)); }
+
+      // all allocators are interchangeable
+      template <typename U>
+      bool operator==(const AlignedAllocator<U,A>&) const { return true; }
+      template <typename U>
+      bool operator!=(const AlignedAllocator<U,A>&) const { return false; }
+  };
+
+  /* std::vector whose storage starts on a cache line */
+  template <typename T>
+  using AlignedVector = std::vector<T, AlignedAllocator<T> >;
+}
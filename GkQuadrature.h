@@ -0,0 +1,436 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Gaussian quadrature of functions of HyperReal numbers
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace Gkyl {
+
+  /* N-point Gauss-Legendre ordinates and weights on [-1,1], stored
+   * as lanes of type T. The ordinates are computed once, using
+   * Newton iterations on the Legendre polynomial P_N, with P_N'
+   * computed using HyperDouble numbers */
+  template <int N, typename T=double>
+  class GaussLegendre {
+    public:
+      // fetch (the only) instance
+      static const GaussLegendre& get() {
+        static const GaussLegendre gl;
+        return gl;
+      }
+
+      // ordinates in ascending order and corresponding weights
+      const Lanes<T,N>& ordinates() const { return eta; }
+      const Lanes<T,N>& weights() const { return wt; }
+
+    private:
+      GaussLegendre() {
+        const double pi = 3.141592653589793238462643383279502884;
+        for (int i=0; i<N; ++i) {
+          // Newton iterations starting from estimate of i-th root
+          double x = std::cos(pi*(i+0.75)/(N+0.5)), dx = 1.0;
+          HyperDouble p = legendre(HyperDouble(x, 1.0));
+          for (int count=0; count<100 && std::fabs(dx)>1e-15; ++count) {
+            dx = p.real()/p.inf();
+            x = x-dx;
+            p = legendre(HyperDouble(x, 1.0));
+          }
+          // roots are computed in descending order
+          eta[N-1-i] = x;
+          wt[N-1-i] = 2/((1-x*x)*p.inf()*p.inf());
+        }
+      }
+
+      // Legendre polynomial P_N(x) from the three-term recurrence
+      constexpr static HyperDouble legendre(const HyperDouble& x) {
+        HyperDouble p0 = 1.0, p1 = x;
+        for (int k=1; k<N; ++k) {
+          HyperDouble p2 = ((2*k+1)*x*p1-k*p0)/(k+1);
+          p0 = p1; p1 = p2;
+        }
+        return N == 0 ? p0 : p1;
+      }
+
+      Lanes<T,N> eta; /* Ordinates */
+      Lanes<T,N> wt; /* Weights */
+  };
+
+  // Private types to pack a number into N lanes and to reduce packed
+  // numbers with quadrature weights. The number can be a POD
+  // (double/float) or a HyperReal
+  namespace {
+    /* Pack and reduce POD number */
+    template <typename T, int N>
+    struct _q {
+        typedef T real_t;
+        typedef Lanes<T,N> packed_t;
+
+        static packed_t pack(const T& x) { return packed_t(x); }
+        static T reduce(const Lanes<T,N>& w, const packed_t& f) { return wsum(w, f); }
+    };
+
+    /* Pack and reduce HyperReal number: real and infinitesimal
+     * parts are packed separately */
+    template <typename RT, typename AT, int N>
+    struct _q<HyperReal<RT,AT>, N> {
+        typedef RT real_t;
+        typedef HyperReal<Lanes<RT,N>, Lanes<AT,N> > packed_t;
+
+        static packed_t pack(const HyperReal<RT,AT>& x) {
+          return packed_t(Lanes<RT,N>(x.real()), Lanes<AT,N>(x.inf()));
+        }
+        static HyperReal<RT,AT> reduce(const Lanes<RT,N>& w, const packed_t& f) {
+          return HyperReal<RT,AT>(wsum(w, f.real()), wsum(w, f.inf()));
+        }
+    };
+  }
+
+  /* Type of number T packed into N lanes */
+  template <typename T, int N>
+  using Packed = typename _q<T,N>::packed_t;
+
+  /* Pack a number into N lanes. Use this to pass parameters to an
+   * integrand evaluated by quadPacked */
+  template <int N, typename T>
+  inline Packed<T,N> pack(const T& x) { return _q<T,N>::pack(x); }
+
+  /* Computes \int_a^b G(y) dy using N-point Gauss-Legendre
+   * quadrature. The integrand is called once with all N nodes packed
+   * into the lanes of its argument, which is of type Packed<T,N>, and
+   * the result is reduced with the weights across lanes */
+  template <int N, typename T, typename F>
+  inline T quadPacked(const F& G, const T& a, const T& b) {
+    typedef typename _q<T,N>::real_t RT;
+    const GaussLegendre<N,RT>& gl = GaussLegendre<N,RT>::get();
+    T h = (b-a)/2;
+    Packed<T,N> y = pack<N>(a) + pack<N>(h)*(1+gl.ordinates());
+    return h*_q<T,N>::reduce(gl.weights(), G(y));
+  }
+
+  /* Computes F(x) = \int_{a(x)}^{b(x)} G(x,y) dy and its derivative
+   * using the Leibniz rule
+   *
+   *   dF/dx = \int_a^b dG/dx dy + G(x,b) db/dx - G(x,a) da/dx
+   *
+   * The nodes are mapped using the real parts of a and b only, so no
+   * tangents are carried through the node mapping. The integrand is
+   * called once, with x and the nodes packed into lanes (the nodes
+   * have zero infinitesimal part), and its tangent gives dG/dx in the
+   * same sweep as G. The boundary terms need G(x,a) and G(x,b), which
+   * are computed by calling G with real numbers */
+  template <int N, typename RT, typename AT, typename F>
+  inline HyperReal<RT,AT>
+  quadLeibniz(const F& G, const HyperReal<RT,AT>& x,
+    const HyperReal<RT,AT>& a, const HyperReal<RT,AT>& b) {
+    typedef HyperReal<RT,AT> T;
+    const GaussLegendre<N,RT>& gl = GaussLegendre<N,RT>::get();
+    RT x0 = x.real(), a0 = a.real(), b0 = b.real();
+    RT h = (b0-a0)/2;
+    Packed<T,N> y = Lanes<RT,N>(a0) + h*(1+gl.ordinates());
+    T s = _q<T,N>::reduce(gl.weights(), G(pack<N>(x), y));
+    RT ga = G(x0, a0), gb = G(x0, b0);
+    return T(h*s.real(), h*s.inf() + gb*b.inf() - ga*a.inf());
+  }
+
+  /* Computes the Legendre moments of G over the D-dimensional box
+   * [lo,up],
+   *
+   *   M_{k_1...k_D} = \int G(x) P_{k_1}(xi_1)...P_{k_D}(xi_D) dx
+   *
+   * for 0 <= k_d < P, where xi_d in [-1,1] is the coordinate mapped
+   * from [lo_d,up_d], using the tensor product of N-point
+   * Gauss-Legendre rules. G is called at each of the N^D nodes with a
+   * std::array<T,D> of coordinates. The sum over nodes is factorized,
+   * contracting one direction at a time, so it costs O(D P N^D)
+   * instead of O(P^D N^D). Moments are returned with k_D varying
+   * fastest */
+  template <int N, int P, typename T, std::size_t D, typename F>
+  std::vector<T>
+  quadMomentsBox(const F& G, const std::array<T,D>& lo, const std::array<T,D>& up) {
+    typedef typename _q<T,N>::real_t RT;
+    const GaussLegendre<N,RT>& gl = GaussLegendre<N,RT>::get();
+    const Lanes<RT,N>& eta = gl.ordinates();
+
+    // weights times Legendre polynomials at nodes: B[k][j] = w_j P_k(eta_j)
+    RT B[P][N];
+    for (int j=0; j<N; ++j) {
+      RT p0 = 1, p1 = eta[j];
+      for (int k=0; k<P; ++k) {
+        B[k][j] = gl.weights()[j]*p0;
+        RT p2 = ((2*k+3)*eta[j]*p1-(k+1)*p0)/(k+2);
+        p0 = p1; p1 = p2;
+      }
+    }
+
+    // nodes in each direction and Jacobian of map to [-1,1]^D
+    std::array<std::array<T,N>,D> xn;
+    T jac = 1.0;
+    for (std::size_t d=0; d<D; ++d) {
+      T h = (up[d]-lo[d])/2;
+      for (int j=0; j<N; ++j)
+        xn[d][j] = lo[d] + h*(1+eta[j]);
+      jac = jac*h;
+    }
+
+    // integrand at all nodes, last direction varying fastest
+    std::size_t nn = 1;
+    for (std::size_t d=0; d<D; ++d) nn *= N;
+    std::vector<T> f(nn);
+    std::array<int,D> idx; idx.fill(0);
+    std::array<T,D> x;
+    for (std::size_t d=0; d<D; ++d) x[d] = xn[d][0];
+    for (std::size_t n=0; n<nn; ++n) {
+      f[n] = G(x);
+      // advance multi-index
+      for (int d=D-1; d>=0; --d) {
+        if (++idx[d] < N) { x[d] = xn[d][idx[d]]; break; }
+        idx[d] = 0; x[d] = xn[d][0];
+      }
+    }
+
+    // Contract the last index of f[m][j] with B[k][j], storing the
+    // result as g[k][m]: after D sweeps the indices are back in order
+    std::size_t outer = nn/N;
+    for (std::size_t d=0; d<D; ++d) {
+      std::vector<T> g(P*outer);
+      for (int k=0; k<P; ++k)
+        for (std::size_t m=0; m<outer; ++m) {
+          const T *fm = &f[m*N];
+          T s = B[k][0]*fm[0];
+          for (int j=1; j<N; ++j) s += B[k][j]*fm[j];
+          g[k*outer+m] = s;
+        }
+      f.swap(g);
+      if (d+1 < D) outer = outer/N*P;
+    }
+    for (std::size_t i=0; i<f.size(); ++i) f[i] = jac*f[i];
+    return f;
+  }
+
+  /* Computes \int G(x) dx over the D-dimensional box [lo,up] using
+   * the tensor product of N-point Gauss-Legendre rules. See
+   * quadMomentsBox */
+  template <int N, typename T, std::size_t D, typename F>
+  inline T
+  quadBox(const F& G, const std::array<T,D>& lo, const std::array<T,D>& up) {
+    return quadMomentsBox<N,1>(G, lo, up)[0];
+  }
+
+  /* Options for adaptive quadrature */
+  struct QuadAdaptiveOpts {
+      double absTol = 1e-10; /* Absolute error tolerance */
+      double relTol = 1e-10; /* Relative error tolerance */
+      int maxEvals = 100000; /* Maximum number of integrand evaluations */
+      int batch = 8; /* Number of subintervals bisected per sweep */
+  };
+
+  /* Statistics from adaptive quadrature */
+  struct QuadAdaptiveStats {
+      int nevals = 0; /* Number of integrand evaluations */
+      int nintervals = 0; /* Number of subintervals in final partition */
+      double errReal = 0; /* Estimated error in real part */
+      double errInf = 0; /* Estimated error in infinitesimal part */
+      bool converged = false; /* True if tolerances were met */
+  };
+
+  // Private types to compute magnitudes of real and infinitesimal
+  // parts of a number, used in error estimates. The number can be a
+  // POD (double/float), Lanes or a HyperReal
+  namespace {
+    /* Error estimate of QUADPACK's qk15 from e = |K-G|, asc the
+     * integral of |f - K/(b-a)| and abs that of |f| over the interval:
+     * e is scaled by (200 e/asc)^1.5 where that is below 1, as K is
+     * then much more accurate than G, and kept above the round-off in
+     * K, 50 eps abs, with eps that of the number type */
+    inline double _qpErr(double e, double asc, double abs, double eps) {
+      if (asc != 0 && e != 0) e = asc*std::min(1.0, std::pow(200*e/asc, 1.5));
+      if (abs > DBL_MIN/(50*eps)) e = std::max(50*eps*abs, e);
+      return e;
+    }
+
+    /* Magnitude of POD number */
+    template <typename T>
+    struct _mag {
+        static double re(const T& x) { return std::fabs(x); }
+        static double inf(const T& x) { return 0; }
+        // absolute value of each part
+        static T abs(const T& x) { return std::fabs(x); }
+        // error estimates of real and infinitesimal parts (see _qpErr)
+        static double reErr(const T& e, const T& asc, const T& abs) {
+          return _qpErr(std::fabs(e), std::fabs(asc), std::fabs(abs), std::numeric_limits<T>::epsilon());
+        }
+        static double infErr(const T& e, const T& asc, const T& abs) { return 0; }
+    };
+    /* Magnitude of lanes: largest magnitude over lanes */
+    template <typename T, int N, int A>
+    struct _mag<Lanes<T,N,A> > {
+        static double re(const Lanes<T,N,A>& x) {
+          double m = 0;
+          for (int i=0; i<N; ++i) m = std::max(m, _mag<T>::re(x[i]));
+          return m;
+        }
+        static double inf(const Lanes<T,N,A>& x) { return 0; }
+        static Lanes<T,N,A> abs(const Lanes<T,N,A>& x) {
+          Lanes<T,N,A> r;
+          for (int i=0; i<N; ++i) r[i] = _mag<T>::abs(x[i]);
+          return r;
+        }
+        static double reErr(const Lanes<T,N,A>& e, const Lanes<T,N,A>& asc, const Lanes<T,N,A>& abs) {
+          double m = 0;
+          for (int i=0; i<N; ++i) m = std::max(m, _mag<T>::reErr(e[i], asc[i], abs[i]));
+          return m;
+        }
+        static double infErr(const Lanes<T,N,A>& e, const Lanes<T,N,A>& asc, const Lanes<T,N,A>& abs) { return 0; }
+    };
+    /* Magnitude of HyperReal number */
+    template <typename RT, typename AT>
+    struct _mag<HyperReal<RT,AT> > {
+        static double re(const HyperReal<RT,AT>& x) { return _mag<RT>::re(x.real()); }
+        static double inf(const HyperReal<RT,AT>& x) { return _mag<AT>::re(x.inf()); }
+        static HyperReal<RT,AT> abs(const HyperReal<RT,AT>& x) {
+          return HyperReal<RT,AT>(_mag<RT>::abs(x.real()), _mag<AT>::abs(x.inf()));
+        }
+        static double reErr(const HyperReal<RT,AT>& e, const HyperReal<RT,AT>& asc, const HyperReal<RT,AT>& abs) {
+          return _mag<RT>::reErr(e.real(), asc.real(), abs.real());
+        }
+        static double infErr(const HyperReal<RT,AT>& e, const HyperReal<RT,AT>& asc, const HyperReal<RT,AT>& abs) {
+          return _mag<AT>::reErr(e.inf(), asc.inf(), abs.inf());
+        }
+    };
+
+    /* 7-point Gauss, 15-point Kronrod rule on [-1,1]: Kronrod
+     * ordinates (positive half, descending) and weights, and the
+     * weights of the Gauss points, which are ordinates 1, 3, 5 and 7 */
+    const double _gk_xgk[8] = {
+      0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+      0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+      0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+      0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+    };
+    const double _gk_wgk[8] = {
+      0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+      0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+      0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+      0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+    };
+    const double _gk_wg[4] = {
+      0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+      0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+    };
+
+    /* Subinterval with its Kronrod estimate and errors */
+    template <typename T>
+    struct _gk_interval {
+        T a, b; /* Interval */
+        T val; /* Kronrod estimate of integral */
+        double errR, errI; /* Error estimates of real and infinitesimal parts */
+    };
+
+    /* Applies the G7-K15 rule on [a,b], with the error estimate of
+     * QUADPACK (_qpErr) for each part of the result. The rule is
+     * converted to the real type of T, so float integrands are
+     * computed in float */
+    template <typename T, typename F>
+    _gk_interval<T> _gk15(const F& G, const T& a, const T& b) {
+      typedef typename _q<T,1>::real_t RT;
+      T c = (a+b)/2, h = (b-a)/2;
+      T fc = G(c), fm[7], fp[7];
+      T sk = RT(_gk_wgk[7])*fc, sg = RT(_gk_wg[3])*fc;
+      T sa = RT(_gk_wgk[7])*_mag<T>::abs(fc);
+      for (int j=0; j<7; ++j) {
+        T dx = h*RT(_gk_xgk[j]);
+        fm[j] = G(c-dx); fp[j] = G(c+dx);
+        T f2 = fm[j] + fp[j];
+        sk += RT(_gk_wgk[j])*f2;
+        sa += RT(_gk_wgk[j])*(_mag<T>::abs(fm[j]) + _mag<T>::abs(fp[j]));
+        if (j%2 == 1) sg += RT(_gk_wg[j/2])*f2;
+      }
+      // integral of |f - mean| over the interval, mean = sk/2
+      T mean = sk/2;
+      T sasc = RT(_gk_wgk[7])*_mag<T>::abs(fc-mean);
+      for (int j=0; j<7; ++j)
+        sasc += RT(_gk_wgk[j])*(_mag<T>::abs(fm[j]-mean) + _mag<T>::abs(fp[j]-mean));
+      T val = h*sk, err = h*(sk-sg), asc = h*sasc, abs = h*sa;
+      return _gk_interval<T> { a, b, val, _mag<T>::reErr(err, asc, abs), _mag<T>::infErr(err, asc, abs) };
+    }
+  }
+
+  /* Computes \int_a^b G(y) dy using adaptive Gauss-Kronrod (G7-K15)
+   * quadrature. The error of each subinterval is estimated from the
+   * difference of the Kronrod and Gauss estimates as in QUADPACK, and
+   * the error of the integral is the sum over subintervals. For
+   * HyperReal numbers the error is estimated separately for the real
+   * and infinitesimal parts (derivative; largest over lanes), so the
+   * derivative is converged too: the result is converged when the
+   * error of each part is at most max(absTol, relTol*|part|), with
+   * |part| the magnitude of that part of the integral. Each sweep
+   * bisects the opts.batch subintervals with the largest errors
+   * relative to the tolerances, until converged or maxEvals would be
+   * exceeded. Throws std::invalid_argument if opts.batch < 1.
+   * Statistics are returned in stats, if it is not null */
+  template <typename T, typename F>
+  T quadAdaptive(const F& G, const T& a, const T& b,
+    const QuadAdaptiveOpts& opts = QuadAdaptiveOpts(), QuadAdaptiveStats *stats = 0) {
+    if (opts.batch < 1) throw std::invalid_argument("quadAdaptive: batch must be at least 1");
+    std::vector<_gk_interval<T> > work(1, _gk15(G, a, b));
+    int nevals = 15;
+    T total = work[0].val;
+    double errR = work[0].errR, errI = work[0].errI;
+    double tolR = 0, tolI = 0;
+    bool converged = false;
+    while (true) {
+      tolR = std::max({ opts.absTol, opts.relTol*_mag<T>::re(total), DBL_MIN });
+      tolI = std::max({ opts.absTol, opts.relTol*_mag<T>::inf(total), DBL_MIN });
+      converged = errR <= tolR && errI <= tolI;
+      if (converged || nevals+30*opts.batch > opts.maxEvals) break;
+
+      // move subintervals with largest scaled errors to the front
+      auto worse = [=](const _gk_interval<T>& x, const _gk_interval<T>& y) {
+        return std::max(x.errR/tolR, x.errI/tolI) > std::max(y.errR/tolR, y.errI/tolI);
+      };
+      std::size_t nb = std::min<std::size_t>(opts.batch, work.size());
+      std::nth_element(work.begin(), work.begin()+nb-1, work.end(), worse);
+
+      // bisect them
+      for (std::size_t i=0; i<nb; ++i) {
+        _gk_interval<T> iv = work[i];
+        T m = (iv.a+iv.b)/2;
+        work[i] = _gk15(G, iv.a, m);
+        work.push_back(_gk15(G, m, iv.b));
+        nevals += 30;
+      }
+
+      // sum contributions from scratch to avoid accumulating round-off
+      total = work[0].val;
+      errR = work[0].errR; errI = work[0].errI;
+      for (std::size_t i=1; i<work.size(); ++i) {
+        total += work[i].val;
+        errR += work[i].errR; errI += work[i].errI;
+      }
+    }
+    if (stats) {
+      stats->nevals = nevals;
+      stats->nintervals = work.size();
+      stats->errReal = errR;
+      stats->errInf = errI;
+      stats->converged = converged;
+    }
+    return total;
+  }
+}
@@ -0,0 +1,300 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Reverse-mode AD using a per-thread tape and operator overloading
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Gkyl {
+
+  /* Record of the operations done on ReverseReal numbers, as a list of
+   * nodes, each with up to two parents and the partial derivatives of
+   * the node with respect to them. Every thread has its own tape,
+   * returned by get(), so threads record and sweep independently with
+   * no shared state and no locks. A number recorded on one thread must
+   * not be used on another */
+  template <typename T>
+  class Tape {
+    public:
+      // tape of this thread
+      static Tape& get() {
+        static thread_local Tape t;
+        return t;
+      }
+
+      // number of nodes recorded
+      int size() const { return n; }
+      // drop nodes from position p on, keeping the memory for reuse.
+      // Numbers recorded after p must not be used afterwards
+      void rewind(int p = 0) { n = p; }
+      // make room for m nodes
+      void reserve(int m) { if (m > (int) nodes.size()) nodes.resize(m); }
+
+      // record node with no parents (an input), or with parents a, b
+      // (-1: none) and partial derivatives wa, wb. The nodes are kept
+      // in a vector that only grows, so that recording is a store
+      int push(int a = -1, const T& wa = T(0), int b = -1, const T& wb = T(0)) {
+        if (n == (int) nodes.size()) grow();
+        nodes[n] = Node { a, b, wa, wb };
+        return n++;
+      }
+
+      // adjoint of node i after a sweep
+      T adjoint(int i) const { return i >= alo && i < ahi ? adj[i] : T(0); }
+
+      // sweep back from node i with adjoint 1, down to node lo: adjoint(j)
+      // is then the derivative of node i with respect to node j >= lo.
+      // Nodes before lo are taken as constants, so a sweep costs only
+      // the nodes recorded since lo. Earlier adjoints are discarded
+      void gradient(int i, int lo = 0) {
+        if (i >= (int) adj.size()) adj.resize(i+1);
+        std::fill(adj.begin()+lo, adj.begin()+i+1, T(0));
+        alo = lo; ahi = i+1;
+        adj[i] = T(1);
+        for (int k=i; k>=lo; --k) {
+          T ak = adj[k];
+          if (ak == T(0)) continue;
+          const Node& nd = nodes[k];
+          if (nd.a >= lo) adj[nd.a] = _fma(nd.wa, ak, adj[nd.a]);
+          if (nd.b >= lo) adj[nd.b] = _fma(nd.wb, ak, adj[nd.b]);
+        }
+      }
+
+    private:
+      struct Node {
+          int a, b; /* Parents (-1: none) */
+          T wa, wb; /* Partial derivatives with respect to parents */
+      };
+      int n = 0; /* Number of nodes recorded */
+      std::vector<Node> nodes; /* Recorded nodes, and room for more */
+      std::vector<T> adj; /* Adjoints from last sweep */
+      int alo = 0, ahi = 0; /* Nodes with adjoints from last sweep */
+
+      [[gnu::noinline]] void grow() { nodes.resize(n < 1024 ? 1024 : 2*n); }
+
+      Tape() = default;
+      Tape(const Tape&) = delete;
+      Tape& operator=(const Tape&) = delete;
+  };
+
+  /* Number recorded on the tape of the thread that makes it: a value
+   * and the index of its node (-1 for a passive number, which is not
+   * recorded). Make inputs with ReverseReal<double>::input(x), evaluate,
+   * call gradient() on an output, and read the derivatives of that
+   * output with adjoint() of the inputs. Math functions are the Gkyl::
+   * functions, as for HyperReal numbers */
+  template <typename T>
+  class ReverseReal {
+    public:
+      // various ctors
+      ReverseReal() : v(0), i(-1) { }
+      ReverseReal(const T& rel) : v(rel), i(-1) { }
+      // value with node i
+      ReverseReal(const T& rel, int i) : v(rel), i(i) { }
+
+      // input: a new node with no parents
+      static ReverseReal input(const T& rel) { return ReverseReal(rel, Tape<T>::get().push()); }
+
+      // value and node of number
+      T real() const { return v; }
+      int index() const { return i; }
+      // true if number is recorded
+      bool active() const { return i >= 0; }
+
+      // sweep back from this number down to node lo: see Tape::gradient
+      void gradient(int lo = 0) const { if (i >= 0) Tape<T>::get().gradient(i, lo); }
+      // derivative of the number last swept from with respect to this one
+      T adjoint() const { return i >= 0 ? Tape<T>::get().adjoint(i) : T(0); }
+
+      // number with value rel and derivative dx with respect to x
+      static ReverseReal unary(const T& rel, const ReverseReal& x, const T& dx) {
+        return x.i < 0 ? ReverseReal(rel) : ReverseReal(rel, Tape<T>::get().push(x.i, dx));
+      }
+      // number with value rel and derivatives dx, dy with respect to x, y
+      static ReverseReal binary(const T& rel, const ReverseReal& x, const T& dx, const ReverseReal& y, const T& dy) {
+        if (y.i < 0) return unary(rel, x, dx);
+        if (x.i < 0) return unary(rel, y, dy);
+        return ReverseReal(rel, Tape<T>::get().push(x.i, dx, y.i, dy));
+      }
+
+      // compound assignment +=, -=, *=, /=
+      ReverseReal& operator+=(const ReverseReal& y) { return *this = *this + y; }
+      ReverseReal& operator-=(const ReverseReal& y) { return *this = *this - y; }
+      ReverseReal& operator*=(const ReverseReal& y) { return *this = *this * y; }
+      ReverseReal& operator/=(const ReverseReal& y) { return *this = *this / y; }
+
+      // binary +
+      friend ReverseReal operator+(const ReverseReal& x, const ReverseReal& y) { return binary(x.v+y.v, x, T(1), y, T(1)); }
+      friend ReverseReal operator+(const ReverseReal& x, const T& y) { return unary(x.v+y, x, T(1)); }
+      friend ReverseReal operator+(const T& x, const ReverseReal& y) { return unary(x+y.v, y, T(1)); }
+      // binary -
+      friend ReverseReal operator-(const ReverseReal& x, const ReverseReal& y) { return binary(x.v-y.v, x, T(1), y, T(-1)); }
+      friend ReverseReal operator-(const ReverseReal& x, const T& y) { return unary(x.v-y, x, T(1)); }
+      friend ReverseReal operator-(const T& x, const ReverseReal& y) { return unary(x-y.v, y, T(-1)); }
+      // binary *
+      friend ReverseReal operator*(const ReverseReal& x, const ReverseReal& y) { return binary(x.v*y.v, x, y.v, y, x.v); }
+      friend ReverseReal operator*(const ReverseReal& x, const T& y) { return unary(x.v*y, x, y); }
+      friend ReverseReal operator*(const T& x, const ReverseReal& y) { return unary(x*y.v, y, x); }
+      // binary /: d(x/y) = dx/y - (x/y) dy/y
+      friend ReverseReal operator/(const ReverseReal& x, const ReverseReal& y) {
+        T r = 1/y.v, q = _quot(x.v, y.v, r);
+        return binary(q, x, r, y, -q*r);
+      }
+      friend ReverseReal operator/(const ReverseReal& x, const T& y) { T r = 1/y; return unary(_quot(x.v, y, r), x, r); }
+      friend ReverseReal operator/(const T& x, const ReverseReal& y) { T r = 1/y.v, q = _quot(x, y.v, r); return unary(q, y, -q*r); }
+
+      // unary -, +
+      ReverseReal operator-() const { return unary(-v, *this, T(-1)); }
+      ReverseReal operator+() const { return *this; }
+
+      // relational and equality operators compare values
+      friend bool operator<(const ReverseReal& x, const ReverseReal& y) { return x.v < y.v; }
+      friend bool operator>(const ReverseReal& x, const ReverseReal& y) { return x.v > y.v; }
+      friend bool operator<=(const ReverseReal& x, const ReverseReal& y) { return x.v <= y.v; }
+      friend bool operator>=(const ReverseReal& x, const ReverseReal& y) { return x.v >= y.v; }
+      friend bool operator==(const ReverseReal& x, const ReverseReal& y) { return x.v == y.v; }
+      friend bool operator!=(const ReverseReal& x, const ReverseReal& y) { return x.v != y.v; }
+
+    private:
+      T v; /* Value */
+      int i; /* Node on tape (-1: passive) */
+  };
+
+  // Predefined types
+  using ReverseDouble = ReverseReal<double>;
+
+  namespace {
+    // specialization to ReverseReal: each function records one node
+    // with the derivative of the function
+    template <typename T>
+    struct _m<ReverseReal<T> > {
+        typedef ReverseReal<T> RR;
+
+        static RR sqrt(const RR& x) {
+          T y0 = _m<T>::sqrt(x.real());
+          return RR::unary(y0, x, 1/(2*y0));
+        }
+        static RR cos(const RR& x) { return RR::unary(_m<T>::cos(x.real()), x, -_m<T>::sin(x.real())); }
+        static RR sin(const RR& x) { return RR::unary(_m<T>::sin(x.real()), x, _m<T>::cos(x.real())); }
+        static RR tan(const RR& x) {
+          T t = _m<T>::tan(x.real());
+          return RR::unary(t, x, _fma(t, t, T(1)));
+        }
+        static RR asin(const RR& x) {
+          T x0 = x.real();
+          return RR::unary(_m<T>::asin(x0), x, 1/_m<T>::sqrt(_fma(-x0, x0, T(1))));
+        }
+        static RR acos(const RR& x) {
+          T x0 = x.real();
+          return RR::unary(_m<T>::acos(x0), x, -1/_m<T>::sqrt(_fma(-x0, x0, T(1))));
+        }
+        static RR atan(const RR& x) {
+          T x0 = x.real();
+          return RR::unary(_m<T>::atan(x0), x, 1/_fma(x0, x0, T(1)));
+        }
+        static RR sinh(const RR& x) { return RR::unary(_m<T>::sinh(x.real()), x, _m<T>::cosh(x.real())); }
+        static RR cosh(const RR& x) { return RR::unary(_m<T>::cosh(x.real()), x, _m<T>::sinh(x.real())); }
+        static RR tanh(const RR& x) {
+          T t = _m<T>::tanh(x.real());
+          return RR::unary(t, x, _fma(-t, t, T(1)));
+        }
+        static RR exp(const RR& x) {
+          T e = _m<T>::exp(x.real());
+          return RR::unary(e, x, e);
+        }
+        static RR log(const RR& x) { return RR::unary(_m<T>::log(x.real()), x, 1/x.real()); }
+        static RR abs(const RR& x) { return RR::unary(_m<T>::abs(x.real()), x, sgn(x.real())); }
+        static RR floor(const RR& x) { return RR(_m<T>::floor(x.real())); }
+        static RR ceil(const RR& x) { return RR(_m<T>::ceil(x.real())); }
+        static RR cbrt(const RR& x) {
+          T y0 = _m<T>::cbrt(x.real());
+          return RR::unary(y0, x, 1/(3*y0*y0));
+        }
+
+        // x^n: x^(n-1) is shared by value and derivative
+        static RR powi(const RR& x, long n) {
+          T x0 = x.real();
+          if (n == 0) return RR(T(1));
+          if (n < 0) {
+            T y0 = 1/_m<T>::powi(x0, -n);
+            return RR::unary(y0, x, T(n)*y0/x0);
+          }
+          T pm1 = _m<T>::powi(x0, n-1);
+          return RR::unary(pm1*x0, x, T(n)*pm1);
+        }
+        // x^N for compile-time N: one node, rather than one per product
+        template <int N>
+        static RR pown(const RR& x) {
+          T x0 = x.real();
+          if constexpr (N == 0) return RR(T(1));
+          else if constexpr (N < 0) {
+            T y0 = _m<T>::template pown<N>(x0);
+            return RR::unary(y0, x, T(N)*y0/x0);
+          }
+          else {
+            T pm1 = _m<T>::template pown<N-1>(x0);
+            return RR::unary(pm1*x0, x, T(N)*pm1);
+          }
+        }
+        // x^p for passive p
+        static RR pow(const RR& x, const T& p) {
+          T x0 = x.real();
+          return RR::unary(_m<T>::pow(x0, p), x, p*_m<T>::pow(x0, p-1));
+        }
+        // a^y for passive a
+        static RR pow(const T& a, const RR& y) {
+          T p0 = _m<T>::pow(a, y.real());
+          return RR::unary(p0, y, _powDy(a, p0));
+        }
+        // x^y = exp(y log x). The log x term is only recorded if y is
+        // active, so that any x for which x^y is defined has an adjoint
+        static RR pow(const RR& x, const RR& y) {
+          T x0 = x.real(), y0 = y.real(), p0 = _m<T>::pow(x0, y0);
+          if (!y.active()) return RR::unary(p0, x, _powDx(x0, y0, p0));
+          return RR::binary(p0, x, _powDx(x0, y0, p0), y, _powDy(x0, p0));
+        }
+
+        static RR hypot(const RR& x, const RR& y) {
+          T x0 = x.real(), y0 = y.real(), h0 = _m<T>::hypot(x0, y0), r = 1/h0;
+          return RR::binary(h0, x, x0*r, y, y0*r);
+        }
+        static RR atan2(const RR& y, const RR& x) {
+          T x0 = x.real(), y0 = y.real(), r = 1/_fma(x0, x0, y0*y0);
+          return RR::binary(_m<T>::atan2(y0, x0), y, x0*r, x, -y0*r);
+        }
+    };
+  }
+
+  /* Jacobian (row-major, nout x nin) at x, using one reverse sweep
+   * per output after a single recording. f(x,y) must be callable with
+   * std::vector of ReverseReal<double> numbers. The tape of the calling
+   * thread is rewound to where it was on return, so this can be called
+   * from many threads at once. The sweeps stop at the inputs, so nodes
+   * recorded before the call cost nothing */
+  template <typename F>
+  void reverseJacobian(const F& f, const std::vector<double>& x, int nout, std::vector<double>& J) {
+    Tape<double>& tape = Tape<double>::get();
+    int p0 = tape.size(), n = x.size();
+    std::vector<ReverseDouble> rx(n), ry(nout);
+    for (int j=0; j<n; ++j) rx[j] = ReverseDouble::input(x[j]);
+    f(rx, ry);
+    J.assign(nout*n, 0.0);
+    for (int i=0; i<nout; ++i) {
+      if (!ry[i].active()) continue;
+      ry[i].gradient(p0);
+      for (int j=0; j<n; ++j) J[i*n+j] = rx[j].adjoint();
+    }
+    tape.rewind(p0);
+  }
+}
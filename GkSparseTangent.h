@@ -0,0 +1,211 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Sparse tangents, for forward mode with many inputs
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+#include <GkPool.h>
+
+// std includes
+#include <stdexcept>
+
+namespace Gkyl {
+
+  /* Sparse vector of numbers: sorted (index, value) pairs of the
+   * entries that can be nonzero, with an unbounded number of indices.
+   * Zero has no entries. Up to K entries are stored inline, more in
+   * blocks from the per-thread BlockPool. Use as the infinitesimal
+   * part of a HyperReal, HyperReal<double,SparseTangent<double>>, with
+   * input j seeded by SparseTangent<double>::unit(j): the tangent of each
+   * quantity then holds its derivatives with respect to the inputs it
+   * actually depends on, and costs time proportional to their number.
+   * This gives sparse Jacobians in one pass, without coloring */
+  template <typename T, int K = 4>
+  class SparseTangent {
+    public:
+      // various ctors. The only scalar that is a sparse tangent is zero
+      SparseTangent() : n(0), c(-1), hv(0), hi(0) { }
+      SparseTangent(const T& s) : SparseTangent() {
+        if (s != T(0)) throw std::invalid_argument("SparseTangent: nonzero scalar");
+      }
+      SparseTangent(const SparseTangent& x) : SparseTangent() { copy(x); }
+      SparseTangent(SparseTangent&& x) noexcept : SparseTangent() { steal(x); }
+      ~SparseTangent() { free(); }
+
+      SparseTangent& operator=(const SparseTangent& x) {
+        if (this != &x) copy(x);
+        return *this;
+      }
+      SparseTangent& operator=(SparseTangent&& x) noexcept {
+        if (this != &x) steal(x);
+        return *this;
+      }
+
+      // s at index i
+      static SparseTangent unit(int i, const T& s = T(1)) {
+        SparseTangent r;
+        r.iv[0] = i; r.vv[0] = s; r.n = 1;
+        return r;
+      }
+
+      // number of entries, and index and value of entry k
+      int nnz() const { return n; }
+      int index(int k) const { return idx()[k]; }
+      T value(int k) const { return val()[k]; }
+      // true if all entries are zero
+      bool empty() const { return n == 0; }
+
+      // value at index i (binary search)
+      T operator[](int i) const {
+        const int *ix = idx();
+        int a = 0, b = n;
+        while (a < b) {
+          int m = (a+b)/2;
+          if (ix[m] < i) a = m+1; else b = m;
+        }
+        return a < n && ix[a] == i ? val()[a] : T(0);
+      }
+
+      // compound assignment +=, -=, *=, /=
+      SparseTangent& operator+=(const SparseTangent& y) { return axpy(T(1), y); }
+      SparseTangent& operator-=(const SparseTangent& y) { return axpy(T(-1), y); }
+      SparseTangent& operator*=(const T& s) {
+        T *v = val();
+        for (int k=0; k<n; ++k) v[k] *= s;
+        return *this;
+      }
+      SparseTangent& operator/=(const T& s) {
+        T *v = val();
+        for (int k=0; k<n; ++k) v[k] /= s;
+        return *this;
+      }
+
+      // binary +, -
+      friend SparseTangent operator+(const SparseTangent& x, const SparseTangent& y) {
+        SparseTangent r;
+        r.merge(x, T(1), y, T(1));
+        return r;
+      }
+      friend SparseTangent operator-(const SparseTangent& x, const SparseTangent& y) {
+        SparseTangent r;
+        r.merge(x, T(1), y, T(-1));
+        return r;
+      }
+      // binary *, / by scalar
+      friend SparseTangent operator*(const SparseTangent& x, const T& s) { SparseTangent r(x); return r *= s; }
+      friend SparseTangent operator*(const T& s, const SparseTangent& x) { SparseTangent r(x); return r *= s; }
+      friend SparseTangent operator/(const SparseTangent& x, const T& s) { SparseTangent r(x); return r /= s; }
+
+      // unary -, +
+      SparseTangent operator-() const { SparseTangent r(*this); return r *= T(-1); }
+      SparseTangent operator+() const { return *this; }
+
+      // a*s+c in one merge. This is found by argument-dependent lookup
+      // from the HyperReal operators, in preference to the generic _fma
+      friend SparseTangent _fma(const SparseTangent& a, const T& s, const SparseTangent& c) {
+        SparseTangent r;
+        r.merge(a, s, c, T(1));
+        return r;
+      }
+
+      // true if all entries are zero: found by argument-dependent lookup
+      // where the HyperReal rules skip terms scaled by a zero tangent
+      friend bool _isZero(const SparseTangent& x) {
+        const T *v = x.val();
+        for (int k=0; k<x.n; ++k) if (v[k] != T(0)) return false;
+        return true;
+      }
+
+    private:
+      int n; /* Number of entries */
+      int c; /* Size class of pooled block (-1: inline storage) */
+      T *hv; /* Values in pooled block */
+      int *hi; /* Indices in pooled block */
+      T vv[K]; /* Inline values */
+      int iv[K]; /* Inline indices */
+
+      // capacity of size class
+      static int capacity(int c) {
+        return c < 0 ? K : BlockPool::blockSize(c)/(sizeof(T)+sizeof(int));
+      }
+
+      const int* idx() const { return c < 0 ? iv : hi; }
+      int* idx() { return c < 0 ? iv : hi; }
+      const T* val() const { return c < 0 ? vv : hv; }
+      T* val() { return c < 0 ? vv : hv; }
+
+      void free() {
+        if (c >= 0) BlockPool::release(hv, c);
+        c = -1; n = 0;
+      }
+
+      // make room for m entries, discarding the current ones
+      void reserve(int m) {
+        if (m <= capacity(c)) return;
+        free();
+        int nc = BlockPool::sizeClass(m*(sizeof(T)+sizeof(int)));
+        void *p = BlockPool::get(nc);
+        hv = static_cast<T*>(p);
+        hi = reinterpret_cast<int*>(hv+capacity(nc));
+        c = nc;
+      }
+
+      void copy(const SparseTangent& x) {
+        reserve(x.n);
+        n = x.n;
+        const int *xi = x.idx(); const T *xv = x.val();
+        int *ri = idx(); T *rv = val();
+        for (int k=0; k<n; ++k) { ri[k] = xi[k]; rv[k] = xv[k]; }
+      }
+
+      // take entries of x, leaving it zero. A pooled block is moved
+      // rather than copied
+      void steal(SparseTangent& x) {
+        if (x.c < 0) copy(x);
+        else {
+          free();
+          c = x.c; hv = x.hv; hi = x.hi; n = x.n;
+          x.c = -1;
+        }
+        x.n = 0;
+      }
+
+      // this = sa*a + sb*b, by merging the sorted indices. Neither a
+      // nor b can be this
+      void merge(const SparseTangent& a, const T& sa, const SparseTangent& b, const T& sb) {
+        reserve(a.n+b.n);
+        const int *ai = a.idx(), *bi = b.idx(); const T *av = a.val(), *bv = b.val();
+        int *ri = idx(); T *rv = val();
+        int i = 0, j = 0, k = 0;
+        while (i < a.n && j < b.n) {
+          if (ai[i] < bi[j]) { ri[k] = ai[i]; rv[k++] = av[i++]*sa; }
+          else if (bi[j] < ai[i]) { ri[k] = bi[j]; rv[k++] = bv[j++]*sb; }
+          else { ri[k] = ai[i]; rv[k++] = _fma(av[i++], sa, bv[j++]*sb); }
+        }
+        for (; i < a.n; ++i) { ri[k] = ai[i]; rv[k++] = av[i]*sa; }
+        for (; j < b.n; ++j) { ri[k] = bi[j]; rv[k++] = bv[j]*sb; }
+        n = k;
+      }
+
+      // this += s*y
+      SparseTangent& axpy(const T& s, const SparseTangent& y) {
+        if (y.n == 0) return *this;
+        SparseTangent r;
+        r.merge(y, s, *this, T(1));
+        steal(r);
+        return *this;
+      }
+  };
+
+  namespace {
+    /* SparseTangent tangents are scaled by a scalar */
+    template <typename T, int K, typename RT>
+    struct _S<SparseTangent<T,K>, RT> { typedef typename _S<T,RT>::type type; };
+  }
+}
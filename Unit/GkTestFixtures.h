@@ -0,0 +1,46 @@
+// Gkyl ------------------------------------------------------------------------
+//
+// Test functions shared by the unit tests of the number types
+//    _______     ___
+// + 6 @ |||| # P ||| +
+//------------------------------------------------------------------------------
+
+
+#pragma once
+
+// gkyl includes
+#include <GkForwardAutoDiff.h>
+
+// std includes
+#include <cmath>
+#include <vector>
+
+// Scalar function of x > 0 using the four operators and several math
+// functions
+template <typename T>
+T
+testFunc(const T& x) {
+  return x*x*Gkyl::cos(x)/(1+Gkyl::exp(-1.0*x)) + Gkyl::sqrt(x)*Gkyl::log(x) - Gkyl::atan(x/3);
+}
+
+// Derivative of testFunc, worked out by hand: a reference that does
+// not depend on the differentiation rules being tested
+inline double
+testFuncDeriv(double x) {
+  double e = std::exp(-x), d = 1+e;
+  return ((2*x*std::cos(x) - x*x*std::sin(x))*d + x*x*std::cos(x)*e)/(d*d)
+    + std::log(x)/(2*std::sqrt(x)) + 1/std::sqrt(x) - 3/(9+x*x);
+}
+
+// Dense function of n inputs: y_i = x_i*sin(x_{i+1}) + exp(x_i)/(2+x_{i+1}^2),
+// indices cyclic
+struct CyclicFunc {
+    template <typename T>
+    void operator()(const std::vector<T>& x, std::vector<T>& y) const {
+      int n = x.size();
+      for (int i=0; i<n; ++i) {
+        const T& xn = x[(i+1)%n];
+        y[i] = x[i]*Gkyl::sin(xn) + Gkyl::exp(x[i])/(2+xn*xn);
+      }
+    }
+};
@@ -0,0 +1,83 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkBlockLanes.h>
+#include <GkProblems.h>
+#include <GkTestFixtures.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+typedef Gkyl::BlockLanes<double,16> BL;
+typedef Gkyl::HyperReal<double,BL> HyperBlock;
+
+TEST_CASE("Ranges of BlockLanes", "[block-lanes]") {
+  const BL z(0.0), c(2.0);
+  REQUIRE( z.empty() );
+  REQUIRE( c.lo() == 0 );
+  REQUIRE( c.hi() == 16 );
+
+  // sum of disjoint ranges covers the gap, which is zero
+  const BL s = BL::unit(3, 2.0) + BL::unit(7, -1.0);
+  REQUIRE( s.lo() == 3 );
+  REQUIRE( s.hi() == 8 );
+  REQUIRE( s[3] == 2.0 );
+  REQUIRE( s[7] == -1.0 );
+  for (int i=4; i<7; ++i)
+    REQUIRE( s[i] == 0.0 );
+  REQUIRE( s[0] == 0.0 );
+  REQUIRE( s[15] == 0.0 );
+
+  // scaling does not change the range, and adding zero does not either
+  const BL t = 3.0*s - BL(0.0);
+  REQUIRE( t.lo() == 3 );
+  REQUIRE( t.hi() == 8 );
+  REQUIRE( t[7] == -3.0 );
+
+  // writing to a lane adds it to the range
+  BL w = BL::unit(5);
+  w[1] = 4.0;
+  REQUIRE( w.lo() == 1 );
+  REQUIRE( w.hi() == 6 );
+  REQUIRE( w[2] == 0.0 );
+}
+
+TEST_CASE("HyperReal with BlockLanes", "[block-lanes]") {
+  // math functions keep the range of the seeded lane, and give the
+  // derivative worked out by hand
+  HyperBlock x(5.0, BL::unit(9)), z = testFunc(x);
+  REQUIRE( z.real() == Approx(testFunc(5.0)) );
+  REQUIRE( z.inf()[9] == Approx(testFuncDeriv(5.0)) );
+  REQUIRE( z.inf().lo() == 9 );
+  REQUIRE( z.inf().hi() == 10 );
+
+  // a product of inputs far apart spans the lanes between them, which
+  // stay zero, and a passive factor keeps the range
+  HyperBlock a(2.0, BL::unit(2)), b(3.0, BL::unit(12)), p = a*b + 4.0*a;
+  REQUIRE( p.inf().lo() == 2 );
+  REQUIRE( p.inf().hi() == 13 );
+  REQUIRE( p.inf()[2] == 7.0 );
+  REQUIRE( p.inf()[12] == 2.0 );
+  REQUIRE( p.inf()[7] == 0.0 );
+  REQUIRE( (4.0*a).inf().hi() == 3 );
+
+  // Jacobian of the tridiagonal Broyden function in one sweep: each
+  // output has only the lanes of its three inputs, which hold the
+  // entries 3-4x_i, -1 and -2 of the Jacobian
+  BroydenTridiagonal pb;
+  pb.n = 16;
+  int n = pb.n;
+  std::vector<HyperBlock> hx(n), hy(n);
+  for (int j=0; j<n; ++j) hx[j] = HyperBlock(pb.x0(j), BL::unit(j));
+  pb.eval(hx, hy);
+  for (int i=0; i<n; ++i) {
+    const BL d = hy[i].inf();
+    REQUIRE( d.lo() == std::max(i-1, 0) );
+    REQUIRE( d.hi() == std::min(i+2, n) );
+    for (int j=0; j<n; ++j) {
+      double Jij = j == i ? 3-4*pb.x0(i) : j == i-1 ? -1.0 : j == i+1 ? -2.0 : 0.0;
+      REQUIRE( d[j] == Approx(Jij) );
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkComplexStep.h>
+#include <GkTestFixtures.h>
+#include <cmath>
+
+TEST_CASE("Basic complex-step derivative tests", "[complex-step]") {
+  Gkyl::ComplexStepDouble x(5.0, 1.0);
+  Gkyl::ComplexStepDouble z;
+
+  // f(x) = 2*x^2
+  z = 2*x*x;
+  REQUIRE( z.real() == 50.0 );
+  REQUIRE( z.inf() == Approx(20.0) );
+
+  // f(x) = x/(1+x)
+  z = x/(1+x);
+  REQUIRE( z.real() == Approx(5./(1+5)) );
+  REQUIRE( z.inf() == Approx(1./(5*5+2*5+1)) );
+
+  // f(x) = cos(x*sin(x))
+  z = Gkyl::cos(x*Gkyl::sin(x));
+  REQUIRE( z.real() == Approx(std::cos(5*std::sin(5))) );
+  REQUIRE( z.inf() == Approx(-0.4578343032148585) );
+
+  // f(x) = abs(x)
+  z = Gkyl::abs(Gkyl::ComplexStepDouble(-5.0, 1.0));
+  REQUIRE( z.real() == 5.0 );
+  REQUIRE( z.inf() == -1.0 );
+
+  // f(x) = x>5 then x*x else x*x*x
+  z = x>5 ? x*x : x*x*x;
+  REQUIRE( z.real() == 125.0 );
+  REQUIRE( z.inf() == Approx(75.0) );
+}
+
+TEST_CASE("Complex-step agrees with HyperReal", "[complex-step-hyperreal]") {
+  for (double x0 : { 0.3, 1.0, 2.5, 7.0 }) {
+    Gkyl::ComplexStepDouble zc = testFunc(Gkyl::ComplexStepDouble(x0, 1.0));
+    Gkyl::HyperDouble zh = testFunc(Gkyl::HyperDouble(x0, 1.0));
+    REQUIRE( zc.real() == Approx(zh.real()) );
+    REQUIRE( zc.inf() == Approx(zh.inf()).epsilon(1e-12) );
+    // both agree with the derivative worked out by hand
+    REQUIRE( zc.inf() == Approx(testFuncDeriv(x0)).epsilon(1e-12) );
+  }
+
+  // inverse trig and hyperbolic functions
+  Gkyl::ComplexStepDouble t(0.5, 1.0);
+  Gkyl::HyperDouble th(0.5, 1.0);
+  REQUIRE( Gkyl::asin(t).inf() == Approx(Gkyl::asin(th).inf()) );
+  REQUIRE( Gkyl::acos(t).inf() == Approx(Gkyl::acos(th).inf()) );
+  REQUIRE( Gkyl::tan(t).inf() == Approx(Gkyl::tan(th).inf()) );
+  REQUIRE( Gkyl::sinh(t).inf() == Approx(Gkyl::sinh(th).inf()) );
+  REQUIRE( Gkyl::cosh(t).inf() == Approx(Gkyl::cosh(th).inf()) );
+  REQUIRE( Gkyl::tanh(t).inf() == Approx(Gkyl::tanh(th).inf()) );
+
+  // powers and two-argument functions
+  Gkyl::ComplexStepDouble u(-1.5, 1.0);
+  Gkyl::HyperDouble uh(-1.5, 1.0);
+  REQUIRE( Gkyl::pow(u, 3).inf() == Approx(Gkyl::pow(uh, 3).inf()) );
+  REQUIRE( Gkyl::pow(t, 2.5).inf() == Approx(Gkyl::pow(th, 2.5).inf()) );
+  REQUIRE( Gkyl::pow(t, t).inf() == Approx(Gkyl::pow(th, th).inf()) );
+  REQUIRE( Gkyl::cbrt(u).real() == Approx(std::cbrt(-1.5)) );
+  REQUIRE( Gkyl::cbrt(u).inf() == Approx(Gkyl::cbrt(uh).inf()) );
+  REQUIRE( Gkyl::hypot(u, 2.0).inf() == Approx(Gkyl::hypot(uh, 2.0).inf()) );
+  REQUIRE( Gkyl::atan2(u, -2.0).inf() == Approx(Gkyl::atan2(uh, -2.0).inf()) );
+}
@@ -0,0 +1,55 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkDiffCheck.h>
+#include <GkTestFixtures.h>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Derivative check of correct derivatives", "[diffcheck]") {
+  Gkyl::DiffCheckOpts opts;
+  opts.npoints = 40;
+  opts.nthreads = 4;
+  Gkyl::DiffCheckResult r = Gkyl::diffCheck(CyclicFunc(), 20, 20, opts);
+
+  REQUIRE( r.nchecked == 40*20*20 );
+  REQUIRE( r.maxErr < 1e-8 );
+  REQUIRE( r.worst.size() == 10 );
+  REQUIRE( r.worst[0].err == r.maxErr );
+  for (std::size_t i=1; i<r.worst.size(); ++i)
+    REQUIRE( r.worst[i-1].err >= r.worst[i].err );
+
+  // result does not depend on the number of threads
+  opts.nthreads = 1;
+  Gkyl::DiffCheckResult r1 = Gkyl::diffCheck(CyclicFunc(), 20, 20, opts);
+  REQUIRE( r1.nchecked == r.nchecked );
+  REQUIRE( r1.maxErr == r.maxErr );
+}
+
+TEST_CASE("Derivative check finds wrong derivatives", "[diffcheck-wrong]") {
+  CyclicFunc f;
+  int n = 12;
+  // Jacobian with one wrong entry
+  auto jac = [&](const std::vector<double>& x, std::vector<double>& J) {
+    Gkyl::forwardJacobian(f, x, n, J);
+    J[3*n+4] *= 1.01;
+  };
+  Gkyl::DiffCheckOpts opts;
+  opts.npoints = 16;
+  opts.nworst = 3;
+  Gkyl::DiffCheckResult r = Gkyl::diffCheckJacobian(f, jac, n, n, opts);
+
+  REQUIRE( r.maxErr > 1e-4 );
+  REQUIRE( r.worst.size() == 3 );
+  for (const Gkyl::DiffCheckError& e : r.worst) {
+    REQUIRE( e.out == 3 );
+    REQUIRE( e.in == 4 );
+    REQUIRE( e.x.size() == n );
+  }
+
+  // errors in threads are passed to the caller
+  auto bad = [&](const std::vector<double>& x, std::vector<double>& J) {
+    throw std::runtime_error("bad");
+  };
+  REQUIRE_THROWS_AS( Gkyl::diffCheckJacobian(f, bad, n, n, opts), std::runtime_error );
+}
@@ -0,0 +1,132 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkDynLanes.h>
+#include <GkTestFixtures.h>
+#include <cfenv>
+#include <cmath>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+typedef Gkyl::DynLanes<double> DL;
+typedef Gkyl::HyperReal<double,DL> HyperDyn;
+
+TEST_CASE("Lanes of DynLanes", "[dyn-lanes]") {
+  // a scalar has no lanes, and takes the width of what it meets
+  const DL z(0.0), c(2.0);
+  REQUIRE( z.size() == 0 );
+  REQUIRE( c[5] == 2.0 );
+
+  for (int n : { 3, 8, 20, 100 }) {
+    const DL u = DL::unit(n, n-1, 3.0);
+    REQUIRE( u.size() == n );
+    const DL s = c + u, d = u - c*u/2.0;
+    REQUIRE( s.size() == n );
+    REQUIRE( s[0] == 2.0 );
+    REQUIRE( s[n-1] == 5.0 );
+    REQUIRE( d[n-1] == 0.0 );
+    REQUIRE( (-u)[n-1] == -3.0 );
+
+    // copies and moves keep the lanes; moved-from numbers are scalars
+    DL a(u), b(std::move(a));
+    REQUIRE( a.size() == 0 );
+    REQUIRE( b.size() == n );
+    REQUIRE( b[n-1] == 3.0 );
+    a = b; b = z;
+    REQUIRE( a.size() == n );
+    REQUIRE( a[n-1] == 3.0 );
+    REQUIRE( b.size() == 0 );
+  }
+
+  // division of inline lanes leaves the unused ones alone, so raises
+  // no FE_INVALID from 0/0
+  {
+    DL x = DL::unit(3, 1), y = DL::unit(3, 0, 2.0), z = DL::unit(3, 0);
+    y[1] = y[2] = 2.0;
+    z[1] = z[2] = 1.0;
+    std::feclearexcept(FE_ALL_EXCEPT);
+    const DL q = x/y;
+    z /= DL(x[0]);
+    REQUIRE( !std::fetestexcept(FE_INVALID) );
+    REQUIRE( q[0] == 0.0 );
+    REQUIRE( q[1] == 0.5 );
+    REQUIRE( std::isinf(z[2]) );
+  }
+
+  // moves cannot throw, so vectors of numbers move them when growing
+  static_assert(std::is_nothrow_move_constructible<DL>::value, "");
+  static_assert(std::is_nothrow_move_assignable<DL>::value, "");
+  static_assert(std::is_nothrow_move_constructible<HyperDyn>::value, "");
+}
+
+TEST_CASE("HyperReal with DynLanes", "[dyn-lanes]") {
+  // each lane holds the derivative worked out by hand, with inline
+  // (n <= 8) and pooled lanes: d(x_i f(x_i))/dx_i = f + x_i f'
+  for (int n : { 1, 8, 9, 33 }) {
+    std::vector<HyperDyn> x(n), y(n);
+    for (int i=0; i<n; ++i) x[i] = HyperDyn(1.0+0.1*i, DL::unit(n, i));
+
+    HyperDyn sum = 0.0;
+    for (int i=0; i<n; ++i) {
+      y[i] = testFunc(x[i]);
+      sum += x[i]*y[i];
+    }
+    for (int i=0; i<n; ++i) {
+      double xi = 1.0+0.1*i, f = testFunc(xi), df = testFuncDeriv(xi);
+      REQUIRE( y[i].real() == Approx(f) );
+      REQUIRE( y[i].inf().size() == n );
+      REQUIRE( y[i].inf()[i] == Approx(df) );
+      REQUIRE( sum.inf()[i] == Approx(f + xi*df) );
+    }
+  }
+
+  // passive numbers have no lanes
+  HyperDyn p(2.0), q = 3.0*p + Gkyl::sin(p);
+  REQUIRE( q.inf().size() == 0 );
+  REQUIRE( q.inf()[0] == 0.0 );
+}
+
+TEST_CASE("Storage of DynLanes", "[dyn-lanes]") {
+  // up to K = 8 lanes are inline and use no block from the pool; more
+  // use one, which goes back to the pool of the thread when the number
+  // does, and is then reused. On a new thread, whose pool is empty,
+  // count the blocks for up to 16 lanes the pool holds after each pair
+  // of numbers is gone
+  std::vector<std::size_t> held;
+  std::thread([&held]() {
+      for (int n : { 8, 9, 9 }) {
+        {
+          DL a(n, 1.0), b = a*a;
+        }
+        held.push_back(Gkyl::BlockPool::freeBlocks(0) + Gkyl::BlockPool::freeBlocks(1));
+      }
+    }).join();
+  REQUIRE( held[0] == 0 );
+  REQUIRE( held[1] == 2 );
+  REQUIRE( held[2] == 2 );
+}
+
+TEST_CASE("Pooled blocks across threads", "[block-pool]") {
+  // blocks got on this thread and released on another go back to the
+  // heap once that thread holds maxBytes of them
+  const int n = 100, c = Gkyl::BlockPool::sizeClass(n*sizeof(double));
+  std::vector<DL> x(4000, DL(n, 1.0));
+  std::size_t held = 0;
+  std::thread([&x, &held, c]() {
+      std::vector<DL> y(std::move(x));
+      y.clear();
+      held = Gkyl::BlockPool::freeBlocks(c);
+    }).join();
+  REQUIRE( held > 0 );
+  REQUIRE( held*Gkyl::BlockPool::blockSize(c) <= Gkyl::BlockPool::maxBytes );
+
+  // numbers that outlive the pool of their thread, here as they were
+  // given lanes after the pool was made, free their blocks themselves
+  std::thread([n]() {
+      static thread_local DL keep;
+      DL y(n, 2.0);
+      keep = y;
+    }).join();
+}
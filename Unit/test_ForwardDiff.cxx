@@ -3,6 +3,7 @@
 #include <catch.hpp>
 #include <GkForwardAutoDiff.h>
 #include <cmath>
+#include <random>
 #include <vector>
 
 TEST_CASE("Tests for relational operators", "[relops]") {
@@ -127,13 +128,45 @@ TEST_CASE("Compound assignment tests", "[assignment]") {
   z = 1.0;
   z *= x;
   REQUIRE( z.real() == 5.0 );
-  REQUIRE( z.inf() == 0.0 );
+  REQUIRE( z.inf() == 1.0 );
+
+  z = x;
+  z *= x;
+  REQUIRE( z.real() == 25.0 );
+  REQUIRE( z.inf() == 10.0 );
+
+  z = x;
+  z *= 3;
+  REQUIRE( z.real() == 15.0 );
+  REQUIRE( z.inf() == 3.0 );
 
   // /=
   z = 1.0;
   z /= x;
-  REQUIRE( z.real() == 0.2 );
-  REQUIRE( z.inf() == 0.0 );
+  REQUIRE( z.real() == Approx(0.2) );
+  REQUIRE( z.inf() == Approx(-0.04) );
+
+  z = x;
+  z /= 2;
+  REQUIRE( z.real() == 2.5 );
+  REQUIRE( z.inf() == 0.5 );
+
+  // same as binary operators
+  Gkyl::HyperDouble y(2.0, -3.0);
+  z = x; z *= y;
+  REQUIRE( z.real() == (x*y).real() );
+  REQUIRE( z.inf() == Approx((x*y).inf()) );
+  z = x; z /= y;
+  REQUIRE( z.real() == (x/y).real() );
+  REQUIRE( z.inf() == Approx((x/y).inf()) );
+
+  // vector tangents
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,4> > v(2.0, Gkyl::Lanes<double,4>(1.0));
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,4> > w(v);
+  w *= v; w /= 4.0;
+  REQUIRE( w.real() == 1.0 );
+  for (int i=0; i<4; ++i)
+    REQUIRE( w.inf()[i] == 1.0 );
 
 }
 
@@ -258,3 +291,278 @@ TEST_CASE("Basic first derivative tests", "[simple-first-diff]") {
   REQUIRE( z.real() == 125.0 );
   REQUIRE( z.inf() == 75.0 );
 }
+
+TEST_CASE("Tests for HyperReal with Lanes", "[lanes]") {
+  Gkyl::Lanes<double,4> xs = 0.0;
+  for (int i=0; i<4; ++i) xs[i] = 1.0+i;
+
+  // f(x) = 2*x+1, element-wise
+  Gkyl::Lanes<double,4> ys = 2*xs+1;
+  for (int i=0; i<4; ++i)
+    REQUIRE( ys[i] == 2*(1.0+i)+1 );
+
+  REQUIRE( Gkyl::sum(xs) == 10.0 );
+  REQUIRE( Gkyl::wsum(xs, xs) == 30.0 );
+  // odd widths are summed pairwise too
+  Gkyl::Lanes<double,5> x5 = 0.0, w5 = 2.0;
+  for (int i=0; i<5; ++i) x5[i] = 1.0+i;
+  REQUIRE( Gkyl::sum(x5) == 15.0 );
+  REQUIRE( Gkyl::wsum(w5, x5) == 30.0 );
+  Gkyl::Lanes<double,3> x3 = 1e16;
+  x3[1] = 1.0; x3[2] = -1e16;
+  REQUIRE( Gkyl::sum(x3) == 1.0 ); // serially, (1e16+1)-1e16 is 0
+
+  // f(x) = x*sin(x), at all lanes at once
+  Gkyl::HyperReal<Gkyl::Lanes<double,4> > x(xs, 1.0);
+  Gkyl::HyperReal<Gkyl::Lanes<double,4> > z = x*Gkyl::sin(x);
+  for (int i=0; i<4; ++i) {
+    double x0 = 1.0+i;
+    REQUIRE( z.real()[i] == Approx(x0*std::sin(x0)) );
+    REQUIRE( z.inf()[i] == Approx(std::sin(x0)+x0*std::cos(x0)) );
+  }
+
+  // f(x,y) = x*y*exp(x) with a vector of tangents, one lane per
+  // independent variable
+  Gkyl::Lanes<double,2> da(0.0), db(0.0);
+  da[0] = 1.0; db[1] = 1.0;
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,2> > a(2.0, da), b(3.0, db);
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,2> > w = a*b*Gkyl::exp(a);
+  REQUIRE( w.real() == Approx(6.0*std::exp(2.0)) );
+  REQUIRE( w.inf()[0] == Approx(3.0*std::exp(2.0)+6.0*std::exp(2.0)) );
+  REQUIRE( w.inf()[1] == Approx(2.0*std::exp(2.0)) );
+}
+
+TEST_CASE("Tests for reduced-precision tangents", "[reduced-tangents]") {
+  // bfloat16 storage
+  REQUIRE( sizeof(Gkyl::BFloat16) == 2 );
+  REQUIRE( float(Gkyl::BFloat16(1.5f)) == 1.5f );
+  REQUIRE( float(Gkyl::BFloat16(-0.25f)) == -0.25f );
+  REQUIRE( float(Gkyl::BFloat16(1.0f+1.0f/256)) == 1.0f ); // ties to even
+  REQUIRE( float(Gkyl::BFloat16(1.0f+3.0f/256)) == 1.0f+1.0f/64 );
+  REQUIRE( std::isnan(float(Gkyl::BFloat16(NAN))) );
+
+  // f(x) = x*x*cos(x)/(1+x)+log(x)*sqrt(x)
+  auto f = [](const auto& x) { return x*x*Gkyl::cos(x)/(1+x) + Gkyl::log(x)*Gkyl::sqrt(x); };
+  Gkyl::HyperDouble zd = f(Gkyl::HyperDouble(2.5, 1.0));
+  Gkyl::HyperDoubleF zf = f(Gkyl::HyperDoubleF(2.5, 1.0f));
+  Gkyl::HyperDoubleBF zb = f(Gkyl::HyperDoubleBF(2.5, 1.0f));
+
+  // values are computed in double
+  REQUIRE( zf.real() == zd.real() );
+  REQUIRE( zb.real() == zd.real() );
+  REQUIRE( zf.inf() == Approx(zd.inf()).epsilon(1e-6) );
+  REQUIRE( float(zb.inf()) == Approx(zd.inf()).epsilon(2e-2) );
+
+  // vector tangents stored as float
+  typedef Gkyl::HyperReal<double, Gkyl::Lanes<float,4> > VF;
+  Gkyl::Lanes<float,4> da(0.0f), db(0.0f);
+  da[0] = 1.0f; db[1] = 1.0f;
+  VF a(2.0, da), b(3.0, db);
+  VF w = a*b*Gkyl::exp(a)/b;
+  REQUIRE( w.inf()[0] == Approx(3.0*std::exp(2.0)).epsilon(1e-6) );
+  REQUIRE( w.inf()[1] == Approx(0.0).margin(1e-5) );
+  REQUIRE( w.inf()[2] == 0.0f );
+
+  // bfloat16 lanes are scaled in float and rounded once, as a single
+  // bfloat16 tangent is, so each lane is the scalar tangent exactly
+  typedef Gkyl::Lanes<Gkyl::BFloat16,4> LB;
+  auto g = [](const auto& x) {
+    auto y = Gkyl::sin(x)*x/(x+1) + Gkyl::pow(x, 0.5*x) + Gkyl::atan2(x, Gkyl::hypot(x, 2.0));
+    y *= x; y /= 1+x*x;
+    return y;
+  };
+  int nsame = 0;
+  for (int k=1; k<500; ++k) {
+    LB t(0.0f);
+    t[k%4] = 1.0f;
+    Gkyl::HyperDoubleBF s = g(Gkyl::HyperDoubleBF(0.01*k, 1.0f));
+    Gkyl::HyperReal<double,LB> v = g(Gkyl::HyperReal<double,LB>(0.01*k, t));
+    if (float(v.inf()[k%4]) == float(s.inf()) && float(v.inf()[(k+1)%4]) == 0.0f) ++nsame;
+  }
+  REQUIRE( nsame == 499 );
+}
+
+namespace {
+  // P_3(x) = (5x^3-3x)/2 and a Pade-like rational function
+  constexpr double legendre3[] = { 0.0, -1.5, 0.0, 2.5 };
+  constexpr std::array<double,2> num = {{ 1.0, 0.5 }}, den = {{ 1.0, -0.5 }};
+
+  constexpr Gkyl::HyperDouble cx(0.5, 1.0);
+  constexpr Gkyl::HyperDouble cp = Gkyl::polyval(legendre3, cx);
+  constexpr Gkyl::HyperDouble cr = Gkyl::ratval(num, den, cx);
+  constexpr Gkyl::HyperDouble cz = 3*cx*cx - cx/2 + (-cx);
+
+  // value and derivative are computed by the compiler
+  static_assert(cp.real() == 2.5*0.125-1.5*0.5, "P_3(1/2)");
+  static_assert(cp.inf() == 7.5*0.25-1.5, "P_3'(1/2)");
+  static_assert(cr.real() == 1.25/0.75, "r(1/2)");
+  static_assert(cz.real() == 0.0 && cz.inf() == 1.5, "3x^2-3x/2");
+  static_assert(cx < 1.0 && cx > cz && cx != cp, "relational operators");
+}
+
+TEST_CASE("Tests for constexpr HyperReal", "[constexpr]") {
+  // same functions at run time
+  Gkyl::HyperDouble x(0.5, 1.0);
+  Gkyl::HyperDouble r = Gkyl::ratval(num, den, x);
+  REQUIRE( r.real() == cr.real() );
+  REQUIRE( r.inf() == cr.inf() );
+  REQUIRE( cr.inf() == Approx(1/(0.75*0.75)) );
+
+  REQUIRE( Gkyl::polyval(legendre3, 0.5) == cp.real() );
+  Gkyl::HyperFloat xf(0.5f, 1.0f);
+  REQUIRE( Gkyl::polyval(legendre3, xf).inf() == Approx(cp.inf()) );
+}
+
+TEST_CASE("Tests for power functions", "[pow]") {
+  Gkyl::HyperDouble x(1.5, 1.0), z;
+
+  // integer powers
+  REQUIRE( Gkyl::pow(2.0, 10) == 1024.0 );
+  REQUIRE( Gkyl::pow(2.0f, -2) == 0.25f );
+  for (int n : { -3, -1, 0, 1, 2, 5, 8 }) {
+    z = Gkyl::pow(x, n);
+    REQUIRE( z.real() == Approx(std::pow(1.5, n)) );
+    REQUIRE( z.inf() == Approx(n*std::pow(1.5, n-1)) );
+  }
+  z = Gkyl::pow(Gkyl::HyperDouble(0.0, 1.0), 3);
+  REQUIRE( z.real() == 0.0 );
+  REQUIRE( z.inf() == 0.0 );
+
+  // real powers
+  z = Gkyl::pow(x, 2.5);
+  REQUIRE( z.real() == Approx(std::pow(1.5, 2.5)) );
+  REQUIRE( z.inf() == Approx(2.5*std::pow(1.5, 1.5)) );
+  z = Gkyl::pow(Gkyl::HyperDouble(0.0, 1.0), 2.0);
+  REQUIRE( z.real() == 0.0 );
+  REQUIRE( z.inf() == 0.0 );
+
+  z = Gkyl::pow(3.0, x);
+  REQUIRE( z.real() == Approx(std::pow(3.0, 1.5)) );
+  REQUIRE( z.inf() == Approx(std::pow(3.0, 1.5)*std::log(3.0)) );
+
+  // f(x) = x^(x*x)
+  z = Gkyl::pow(x, x*x);
+  REQUIRE( z.real() == Approx(std::pow(1.5, 2.25)) );
+  REQUIRE( z.inf() == Approx(std::pow(1.5, 2.25)*(2*1.5*std::log(1.5)+1.5)) );
+
+  // a constant exponent needs no log of the base, so bases <= 0 have
+  // derivatives: (x^3)' = 3x^2
+  z = Gkyl::pow(Gkyl::HyperDouble(-2.0, 1.0), Gkyl::HyperDouble(3.0));
+  REQUIRE( z.real() == -8.0 );
+  REQUIRE( z.inf() == Approx(12.0) );
+  z = Gkyl::pow(Gkyl::HyperDouble(0.0, 1.0), Gkyl::HyperDouble(3.0));
+  REQUIRE( z.real() == 0.0 );
+  REQUIRE( z.inf() == 0.0 );
+  z = Gkyl::pow(Gkyl::HyperDouble(0.0, 1.0), Gkyl::HyperDouble(1.0));
+  REQUIRE( z.inf() == 1.0 );
+  z = Gkyl::pow(-2.0, Gkyl::HyperDouble(3.0));
+  REQUIRE( z.real() == -8.0 );
+  REQUIRE( z.inf() == 0.0 );
+  // (0^y)' is zero for y > 0, and (x^y)' undefined for x < 0
+  z = Gkyl::pow(Gkyl::HyperDouble(0.0), Gkyl::HyperDouble(2.0, 1.0));
+  REQUIRE( z.inf() == 0.0 );
+  z = Gkyl::pow(Gkyl::HyperDouble(-2.0), Gkyl::HyperDouble(3.0, 1.0));
+  REQUIRE( std::isnan(z.inf()) );
+  // packed real parts, per lane
+  typedef Gkyl::Lanes<double,2> L2;
+  L2 b0(-2.0);
+  b0[1] = 0.0;
+  Gkyl::HyperReal<L2,L2> pb(b0, L2(1.0)), pe(L2(3.0), L2(0.0));
+  Gkyl::HyperReal<L2,L2> pz = Gkyl::pow(pb, pe);
+  REQUIRE( pz.inf()[0] == Approx(12.0) );
+  REQUIRE( pz.inf()[1] == 0.0 );
+
+  z = Gkyl::cbrt(Gkyl::HyperDouble(-8.0, 1.0));
+  REQUIRE( z.real() == Approx(-2.0) );
+  REQUIRE( z.inf() == Approx(1.0/12) );
+
+  // f(x) = hypot(x, 2x) and atan2(2, x)
+  z = Gkyl::hypot(x, 2*x);
+  REQUIRE( z.real() == Approx(std::sqrt(5.0)*1.5) );
+  REQUIRE( z.inf() == Approx(std::sqrt(5.0)) );
+  REQUIRE( Gkyl::hypot(x, 2.0).inf() == Approx(1.5/2.5) );
+
+  z = Gkyl::atan2(2.0, x);
+  REQUIRE( z.real() == Approx(std::atan2(2.0, 1.5)) );
+  REQUIRE( z.inf() == Approx(-2.0/(1.5*1.5+4.0)) );
+  z = Gkyl::atan2(-x, Gkyl::HyperDouble(-1.0));
+  REQUIRE( z.real() == Approx(std::atan2(-1.5, -1.0)) );
+  REQUIRE( z.inf() == Approx(1.0/(1.0+1.5*1.5)) );
+
+  // vector tangents
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,2> > v(1.5, 2.0);
+  REQUIRE( Gkyl::pow(v, 3).inf()[1] == Approx(2*3*1.5*1.5) );
+}
+
+TEST_CASE("Tests for compile-time powers", "[pow-n]") {
+  static_assert(Gkyl::pow<5>(2.0) == 32.0, "2^5");
+  static_assert(Gkyl::pow<-2>(2.0) == 0.25, "2^-2");
+  constexpr Gkyl::HyperDouble cz = Gkyl::pow<3>(Gkyl::HyperDouble(2.0, 1.0));
+  static_assert(cz.real() == 8.0 && cz.inf() == 12.0, "d(x^3) at 2");
+
+  Gkyl::HyperDouble x(1.5, 1.0), z;
+  z = Gkyl::pow<0>(x);
+  REQUIRE( z.real() == 1.0 );
+  REQUIRE( z.inf() == 0.0 );
+  z = Gkyl::pow<7>(x);
+  REQUIRE( z.real() == Approx(std::pow(1.5, 7)) );
+  REQUIRE( z.inf() == Approx(7*std::pow(1.5, 6)) );
+  z = Gkyl::pow<-3>(x);
+  REQUIRE( z.real() == Approx(std::pow(1.5, -3)) );
+  REQUIRE( z.inf() == Approx(-3*std::pow(1.5, -4)) );
+
+  // agrees with runtime power
+  REQUIRE( Gkyl::pow<6>(x).real() == Gkyl::pow(x, 6).real() );
+  REQUIRE( Gkyl::pow<6>(x).inf() == Gkyl::pow(x, 6).inf() );
+
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,2> > v(1.5, 2.0);
+  REQUIRE( Gkyl::pow<4>(v).inf()[0] == Approx(2*4*std::pow(1.5, 3)) );
+}
+
+TEST_CASE("Tests for quotient and product rules", "[quotient]") {
+  // value of quotient is the primal quotient, bit for bit
+  Gkyl::Lanes<double,2> dx(0.0), dy(0.0);
+  dx[0] = 1.0; dy[1] = 1.0;
+  Gkyl::HyperReal<double, Gkyl::Lanes<double,2> > x(5.0, dx), y(3.0, dy);
+
+  auto q = x/y;
+  REQUIRE( q.real() == 5.0/3.0 );
+  REQUIRE( q.inf()[0] == Approx(1/3.0) );
+  REQUIRE( q.inf()[1] == Approx(-5.0/9.0) );
+
+  auto p = x*y;
+  REQUIRE( p.real() == 15.0 );
+  REQUIRE( p.inf()[0] == 3.0 );
+  REQUIRE( p.inf()[1] == 5.0 );
+
+  // passive numerator and denominator
+  REQUIRE( (2.0/y).inf()[1] == Approx(-2.0/9.0) );
+  REQUIRE( (x/2.0).inf()[0] == 0.5 );
+
+  // the value shares 1/y with the tangent, and is still the primal
+  // quotient bit for bit, including near the ends of the exponent range
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> m(-2.0, 2.0);
+  std::uniform_int_distribution<int> ex(-1070, 1023);
+  int ndiff = 0;
+  for (int k=0; k<20000; ++k) {
+    double a = std::ldexp(m(gen), ex(gen)), b = std::ldexp(m(gen), k%2 ? ex(gen) : ex(gen)/8);
+    Gkyl::HyperDouble ha(a, 1.0), hb(b, 1.0), hq = ha/hb;
+    double q = a/b;
+    if (!(hq.real() == q || (std::isnan(hq.real()) && std::isnan(q))) || std::signbit(hq.real()) != std::signbit(q)) ++ndiff;
+    hq = ha; hq /= hb;
+    if (!(hq.real() == q || (std::isnan(hq.real()) && std::isnan(q))) || std::signbit(hq.real()) != std::signbit(q)) ++ndiff;
+    float af = float(m(gen)), bf = std::ldexp(float(m(gen)), ex(gen)/16);
+    if ((Gkyl::HyperFloat(af, 1.0f)/bf).real() != af/bf) ++ndiff;
+  }
+  REQUIRE( ndiff == 0 );
+
+#ifdef FP_FAST_FMA
+  // where multiply-add is fused, the two-term rules round once: the
+  // unfused results here would be 0
+  const double e = std::ldexp(1.0, -30);
+  Gkyl::HyperDouble a(1.0, 1+e), b(1-e, -1.0), c(1-e, 1.0), d(1.0, 1+e);
+  REQUIRE( (a*b).inf() == -std::ldexp(1.0, -60) );
+  REQUIRE( (c/d).inf() == std::ldexp(1.0, -60) );
+#endif
+}
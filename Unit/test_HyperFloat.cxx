@@ -0,0 +1,60 @@
+// This test is compiled with -Werror=double-promotion, to check that
+// HyperFloat code is computed entirely in single precision
+
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkQuadrature.h>
+#include <array>
+
+template <typename T>
+T
+func(const T& x) {
+  return Gkyl::sqrt(x) + Gkyl::cos(x)*Gkyl::sin(x) + Gkyl::tan(x) + Gkyl::asin(x)*Gkyl::acos(x)
+    + Gkyl::atan(x) + Gkyl::sinh(x)/Gkyl::cosh(x) + Gkyl::tanh(x) + Gkyl::exp(-x)*Gkyl::log(x)
+    + Gkyl::abs(x-1) + Gkyl::floor(x) + Gkyl::ceil(x) + 3*x*x/(x+2) - x/2
+    + Gkyl::pow(x, 3) + Gkyl::pow<-2>(x) + Gkyl::pow(x, 1.5f) + Gkyl::pow(x+1, x) + Gkyl::pow(2.0f, x)
+    + Gkyl::cbrt(x) + Gkyl::hypot(x, 2*x) + Gkyl::atan2(x, x+1);
+}
+
+TEST_CASE("HyperFloat math functions", "[hyperfloat]") {
+  for (float x0 : { 0.1f, 0.35f, 0.8f }) {
+    Gkyl::HyperFloat zf = func(Gkyl::HyperFloat(x0, 1.0f));
+    Gkyl::HyperDouble zd = func(Gkyl::HyperDouble(x0, 1.0));
+    REQUIRE( zf.real() == Approx(zd.real()).epsilon(1e-5) );
+    REQUIRE( zf.inf() == Approx(zd.inf()).epsilon(1e-5) );
+  }
+
+  // packed tangents
+  typedef Gkyl::HyperReal<float, Gkyl::Lanes<float,8> > VF;
+  Gkyl::Lanes<float,8> seed(0.0f);
+  seed[5] = 1.0f;
+  VF zv = func(VF(0.35f, seed));
+  Gkyl::HyperDouble zd = func(Gkyl::HyperDouble(0.35, 1.0));
+  REQUIRE( zv.inf()[5] == Approx(zd.inf()).epsilon(1e-5) );
+  REQUIRE( zv.inf()[0] == 0.0f );
+}
+
+TEST_CASE("HyperFloat quadrature", "[hyperfloat-quad]") {
+  const Gkyl::GaussLegendre<5,float>& gl = Gkyl::GaussLegendre<5,float>::get();
+  REQUIRE( Gkyl::sum(gl.weights()) == Approx(2.0f) );
+
+  // \int_0^b exp(-y) dy = 1-exp(-b)
+  auto G = [](const auto& y) { return Gkyl::exp(-y); };
+  Gkyl::HyperFloat b(1.5f, 1.0f);
+  Gkyl::HyperFloat q = Gkyl::quadPacked<8>(G, Gkyl::HyperFloat(0.0f), b);
+  REQUIRE( q.real() == Approx(1-std::exp(-1.5f)).epsilon(1e-5) );
+  REQUIRE( q.inf() == Approx(std::exp(-1.5f)).epsilon(1e-5) );
+
+  Gkyl::QuadAdaptiveOpts opts;
+  opts.absTol = opts.relTol = 1e-5;
+  Gkyl::HyperFloat qa = Gkyl::quadAdaptive(G, Gkyl::HyperFloat(0.0f), b, opts);
+  REQUIRE( qa.real() == Approx(1-std::exp(-1.5f)).epsilon(1e-5) );
+  REQUIRE( qa.inf() == Approx(std::exp(-1.5f)).epsilon(1e-5) );
+
+  // \int_0^1 \int_0^2 x*y dy dx = 1
+  std::array<float,2> lo = { 0.0f, 0.0f }, up = { 1.0f, 2.0f };
+  float qb = Gkyl::quadBox<3>([](const std::array<float,2>& x) { return x[0]*x[1]; }, lo, up);
+  REQUIRE( qb == Approx(1.0f) );
+}
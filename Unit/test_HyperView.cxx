@@ -0,0 +1,156 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkHyperView.h>
+#include <GkPool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+typedef Gkyl::Lanes<double,4> D4;
+typedef Gkyl::AlignedLanes<double,3> A3;
+
+TEST_CASE("Layout of HyperReal", "[layout]") {
+  REQUIRE( std::is_trivially_copyable<Gkyl::HyperDouble>::value );
+  REQUIRE( std::is_standard_layout<Gkyl::HyperDouble>::value );
+  REQUIRE( alignof(Gkyl::HyperDouble) == alignof(double) );
+  REQUIRE( std::is_trivially_copyable<Gkyl::HyperReal<double,D4> >::value );
+  REQUIRE( sizeof(Gkyl::HyperReal<double,D4>) == 5*sizeof(double) );
+
+  // arrays are interleaved (value, tangent) pairs
+  double buff[6] = { 1.0, 0.5, 2.0, 0.25, 3.0, 0.125 };
+  Gkyl::HyperDouble x[3];
+  std::memcpy(x, buff, sizeof(buff));
+  for (int k=0; k<3; ++k) {
+    REQUIRE( x[k].real() == buff[2*k] );
+    REQUIRE( x[k].inf() == buff[2*k+1] );
+  }
+  x[1] = x[1]*x[1];
+  std::memcpy(buff, x, sizeof(x));
+  REQUIRE( buff[2] == 4.0 );
+  REQUIRE( buff[3] == 1.0 );
+}
+
+TEST_CASE("Views of value and tangent arrays", "[hyper-view]") {
+  int n = 10;
+  std::vector<double> val(n), tan(n, 1.0);
+  for (int k=0; k<n; ++k) val[k] = 1.0+0.5*k;
+
+  // writes through the view land in the arrays
+  Gkyl::HyperView<double> v(val.data(), tan.data(), n);
+  REQUIRE( v.size() == std::size_t(n) );
+  for (std::size_t k=0; k<v.size(); ++k) v[k] = v[k]*Gkyl::sin(v[k]);
+  for (int k=0; k<n; ++k) {
+    double x = 1.0+0.5*k;
+    REQUIRE( val[k] == Approx(x*std::sin(x)) );
+    REQUIRE( tan[k] == Approx(std::sin(x)+x*std::cos(x)) );
+  }
+
+  // assignment copies the number, and compound assignments update it
+  v[0] = 2.0;
+  REQUIRE( val[0] == 2.0 );
+  REQUIRE( tan[0] == 0.0 );
+  v[1] = Gkyl::HyperDouble(3.0, 1.0);
+  v[0] = v[1];
+  v[0] *= v[1];
+  REQUIRE( val[0] == 9.0 );
+  REQUIRE( tan[0] == 6.0 );
+  v[0] /= 3.0;
+  v[0] -= 1.0;
+  REQUIRE( val[0] == 2.0 );
+  REQUIRE( tan[0] == 2.0 );
+  REQUIRE( v[1].real() == 3.0 );
+
+  // references are read as the numbers they refer to in arithmetic,
+  // math functions and comparisons
+  v[2] = 2.0*v[1] - Gkyl::pow(v[1], 2) + Gkyl::hypot(v[1], 4.0)/v[1];
+  REQUIRE( val[2] == Approx(6.0-9.0+5.0/3.0) );
+  REQUIRE( tan[2] == Approx(2.0-6.0+1.0/5.0-5.0/9.0) );
+  REQUIRE( (v[0]*v[1]).inf() == 8.0 );
+  REQUIRE( (-v[1]).inf() == -1.0 );
+  REQUIRE( v[2] < v[1] );
+  REQUIRE( v[1] == 3.0 );
+
+  // read-only views and sub-views
+  Gkyl::ConstHyperView<double> c = v.sub(2, 5);
+  REQUIRE( c.size() == 3 );
+  REQUIRE( c[0].real() == val[2] );
+  REQUIRE( c[2].inf() == tan[4] );
+}
+
+TEST_CASE("Iterators of views", "[hyper-view]") {
+  int n = 6;
+  std::vector<double> val(n, 0.5), tan(n, 1.0);
+  Gkyl::HyperView<double> v(val.data(), tan.data(), n);
+  Gkyl::ConstHyperView<double> c = v;
+  REQUIRE( v.end()-v.begin() == n );
+  REQUIRE( c.end()-c.begin() == n );
+
+  // range-for gives references, which write to the arrays
+  for (auto x : v) x *= x;
+  REQUIRE( val[n-1] == 0.25 );
+  REQUIRE( tan[n-1] == 1.0 );
+
+  // algorithms read numbers from a read-only view and write through
+  // the references of a view
+  Gkyl::HyperDouble s = std::accumulate(c.begin(), c.end(), Gkyl::HyperDouble(0.0));
+  REQUIRE( s.real() == Approx(0.25*n) );
+  REQUIRE( s.inf() == Approx(1.0*n) );
+  std::transform(c.begin()+1, c.end(), v.begin()+1, [](const Gkyl::HyperDouble& x) { return Gkyl::sqrt(x); });
+  REQUIRE( val[0] == 0.25 );
+  REQUIRE( val[1] == 0.5 );
+  REQUIRE( tan[n-1] == 1.0 );
+  REQUIRE( (v.begin()+2)[1].real() == val[3] );
+}
+
+TEST_CASE("Views with Lanes tangents", "[hyper-view]") {
+  double val[3] = { 1.0, 2.0, 3.0 };
+  D4 tan[3];
+  for (int k=0; k<3; ++k) tan[k][k] = 1.0;
+
+  Gkyl::HyperView<double,D4> v(val, tan, 3);
+  Gkyl::HyperReal<double,D4> s = 0.0;
+  for (int k=0; k<3; ++k) s += v[k]*v[k];
+  for (int k=0; k<3; ++k) REQUIRE( s.inf()[k] == 2*val[k] );
+}
+
+TEST_CASE("Aligned and padded lanes", "[aligned-lanes]") {
+  // lanes are padded to a power of two, on a boundary of their size,
+  // up to a cache line, whatever the target flags
+  REQUIRE( alignof(A3) == 32 );
+  REQUIRE( sizeof(A3) == 32 );
+  REQUIRE( sizeof(Gkyl::AlignedLanes<float,3>) == 16 );
+  REQUIRE( sizeof(Gkyl::AlignedLanes<double,8>) == 64 );
+  REQUIRE( alignof(Gkyl::AlignedLanes<double,12>) == 64 );
+  REQUIRE( sizeof(Gkyl::AlignedLanes<double,12>) == 128 );
+  // or up to a given alignment
+  REQUIRE( alignof(Gkyl::AlignedLanes<double,3,16>) == 16 );
+  REQUIRE( sizeof(Gkyl::AlignedLanes<double,3,16>) == 32 );
+  REQUIRE( sizeof(Gkyl::AlignedLanes<double,12,32>) == 96 );
+  REQUIRE( sizeof(Gkyl::Lanes<double,3>) == 3*sizeof(double) );
+  REQUIRE( std::is_trivially_copyable<Gkyl::HyperReal<double,A3> >::value );
+
+  // tangents of each element start on the alignment, in arrays that
+  // start on a cache line
+  typedef Gkyl::HyperReal<double,A3> H;
+  Gkyl::AlignedVector<H> x(7);
+  REQUIRE( reinterpret_cast<std::uintptr_t>(x.data()) % 64 == 0 );
+  for (int k=0; k<7; ++k) {
+    REQUIRE( reinterpret_cast<std::uintptr_t>(&x[k].inf()) % alignof(A3) == 0 );
+    A3 t(0.0);
+    t[k%3] = 1.0;
+    x[k] = H(1.0+k, t);
+  }
+
+  // results agree with unaligned lanes
+  Gkyl::HyperReal<double,Gkyl::Lanes<double,3> > y(2.0, Gkyl::Lanes<double,3>(0.5));
+  H z(2.0, A3(0.5)), s = z*Gkyl::exp(z)/x[2];
+  auto sy = y*Gkyl::exp(y)/Gkyl::HyperReal<double,Gkyl::Lanes<double,3> >(3.0, Gkyl::Lanes<double,3>(x[2].inf()));
+  REQUIRE( s.real() == Approx(sy.real()) );
+  for (int i=0; i<3; ++i) REQUIRE( s.inf()[i] == Approx(sy.inf()[i]) );
+}
@@ -0,0 +1,83 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkOpCounter.h>
+#include <cmath>
+
+typedef Gkyl::Counted<double> CDouble;
+typedef Gkyl::HyperReal<CDouble> CHyperDouble;
+
+TEST_CASE("Counting primal operations", "[opcount-primal]") {
+  Gkyl::OpCounter::reset();
+  CDouble x = 2.0, z;
+  do {
+    Gkyl::OpCountScope scope("primal");
+    z = x*x + 3*x - x/4;
+    z = Gkyl::sin(z) + Gkyl::exp(x);
+  } while (0);
+
+  const Gkyl::OpCounts& c = Gkyl::OpCounter::site("primal");
+  REQUIRE( c.mul == 2 );
+  REQUIRE( c.add == 3 );
+  REQUIRE( c.div == 1 );
+  REQUIRE( c.func[Gkyl::OpCounts::SIN] == 1 );
+  REQUIRE( c.func[Gkyl::OpCounts::EXP] == 1 );
+  REQUIRE( c.funcs() == 2 );
+  REQUIRE( z.value() == Approx(std::sin(4.0+6.0-0.5)+std::exp(2.0)) );
+}
+
+TEST_CASE("Counting HyperReal operations", "[opcount-hyperreal]") {
+  Gkyl::OpCounter::reset();
+  CHyperDouble x(2.0, 1.0), z;
+  do {
+    Gkyl::OpCountScope outer("outer");
+    z = x*x;
+    do {
+      Gkyl::OpCountScope inner("inner");
+      z = Gkyl::sin(x);
+    } while (0);
+    z = z+x;
+  } while (0);
+
+  // value x0*y0 and tangent x0*y1+x1*y0, and z+x
+  const Gkyl::OpCounts& o = Gkyl::OpCounter::site("outer");
+  REQUIRE( o.mul == 3 );
+  REQUIRE( o.add == 3 );
+  REQUIRE( o.funcs() == 0 );
+
+  // sin needs sin and cos, and one multiplication
+  const Gkyl::OpCounts& i = Gkyl::OpCounter::site("inner");
+  REQUIRE( i.func[Gkyl::OpCounts::SIN] == 1 );
+  REQUIRE( i.func[Gkyl::OpCounts::COS] == 1 );
+  REQUIRE( i.mul == 1 );
+
+  REQUIRE( z.real().value() == Approx(std::sin(2.0)+2.0) );
+  REQUIRE( z.inf().value() == Approx(std::cos(2.0)+1.0) );
+
+  // x^3 needs one pow for x^2 and two multiplications
+  Gkyl::OpCounter::reset();
+  do {
+    Gkyl::OpCountScope scope("pow");
+    z = Gkyl::pow(x, 3);
+  } while (0);
+  const Gkyl::OpCounts& p = Gkyl::OpCounter::site("pow");
+  REQUIRE( p.func[Gkyl::OpCounts::POW] == 1 );
+  REQUIRE( p.funcs() == 1 );
+  REQUIRE( p.mul == 3 );
+  REQUIRE( z.inf().value() == Approx(12.0) );
+
+  // a passive operand costs no infinitesimal arithmetic beyond
+  // scaling: 3*x+1 is one multiply each for value and tangent, and
+  // one add for the value only
+  Gkyl::OpCounter::reset();
+  do {
+    Gkyl::OpCountScope scope("passive");
+    z = 3.0*x+1.0;
+  } while (0);
+  const Gkyl::OpCounts& s = Gkyl::OpCounter::site("passive");
+  REQUIRE( s.mul == 2 );
+  REQUIRE( s.add == 1 );
+  REQUIRE( z.real().value() == Approx(7.0) );
+  REQUIRE( z.inf().value() == Approx(3.0) );
+}
@@ -0,0 +1,176 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkQuadrature.h>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+template <typename T>
+T
+Gfunc(T x, T y) {
+  return y*y + x;
+}
+
+TEST_CASE("Gauss-Legendre ordinates and weights", "[gauss-legendre]") {
+  const Gkyl::GaussLegendre<3>& gl3 = Gkyl::GaussLegendre<3>::get();
+  REQUIRE( gl3.ordinates()[0] == Approx(-0.7745966692414833770359) );
+  REQUIRE( gl3.ordinates()[1] == Approx(0.0).margin(1e-15) );
+  REQUIRE( gl3.ordinates()[2] == Approx(0.7745966692414833770359) );
+  REQUIRE( gl3.weights()[0] == Approx(0.5555555555555555555556) );
+  REQUIRE( gl3.weights()[1] == Approx(0.8888888888888888888889) );
+  REQUIRE( gl3.weights()[2] == Approx(0.5555555555555555555556) );
+
+  // N-point rule is exact for polynomials of degree 2N-1
+  const Gkyl::GaussLegendre<8>& gl8 = Gkyl::GaussLegendre<8>::get();
+  for (int p=0; p<16; ++p) {
+    double s = 0.0;
+    for (int i=0; i<8; ++i)
+      s += gl8.weights()[i]*std::pow(gl8.ordinates()[i], p);
+    REQUIRE( s == Approx(p%2 == 0 ? 2.0/(p+1) : 0.0).margin(1e-14) );
+  }
+}
+
+TEST_CASE("Quadrature with packed integrand", "[quad-packed]") {
+  // F(x) = \int_x^{2x^2+x} (y^2+x) dy
+  Gkyl::HyperDouble x(1.0, 1.0);
+  Gkyl::Packed<Gkyl::HyperDouble,3> px = Gkyl::pack<3>(x);
+  Gkyl::HyperDouble res = Gkyl::quadPacked<3>(
+    [&](const Gkyl::Packed<Gkyl::HyperDouble,3>& y) { return Gfunc(px, y); },
+    x, 2*x*x+x);
+  REQUIRE( res.real() == Approx(32.0/3.0) );
+  REQUIRE( res.inf() == Approx(50.0) );
+
+  // same with POD numbers
+  double xr = 1.0;
+  Gkyl::Packed<double,3> pxr = Gkyl::pack<3>(xr);
+  double resr = Gkyl::quadPacked<3>(
+    [&](const Gkyl::Packed<double,3>& y) { return Gfunc(pxr, y); },
+    xr, 2*xr*xr+xr);
+  REQUIRE( resr == Approx(32.0/3.0) );
+
+  // F(x) = \int_0^1 sin(x*y) dy, F'(x) = \int_0^1 y cos(x*y) dy
+  Gkyl::HyperDouble z(2.0, 1.0);
+  Gkyl::Packed<Gkyl::HyperDouble,8> pz = Gkyl::pack<8>(z);
+  Gkyl::HyperDouble fz = Gkyl::quadPacked<8>(
+    [&](const Gkyl::Packed<Gkyl::HyperDouble,8>& y) { return Gkyl::sin(pz*y); },
+    Gkyl::HyperDouble(0.0), Gkyl::HyperDouble(1.0));
+  REQUIRE( fz.real() == Approx((1-std::cos(2.0))/2.0) );
+  REQUIRE( fz.inf() == Approx((2*std::sin(2.0)+std::cos(2.0)-1)/4.0) );
+}
+
+TEST_CASE("Quadrature with Leibniz rule", "[quad-leibniz]") {
+  auto G = [](const auto& x, const auto& y) { return Gfunc(x, y); };
+
+  // F(x) = \int_x^{2x^2+x} (y^2+x) dy
+  Gkyl::HyperDouble x(1.0, 1.0);
+  Gkyl::HyperDouble res = Gkyl::quadLeibniz<3>(G, x, x, 2*x*x+x);
+  REQUIRE( res.real() == Approx(32.0/3.0) );
+  REQUIRE( res.inf() == Approx(50.0) );
+
+  // F(x) = \int_0^{x^2} exp(-x*y) dy
+  auto H = [](const auto& x, const auto& y) { return Gkyl::exp(-1.0*x*y); };
+  Gkyl::HyperDouble z(1.5, 1.0);
+  Gkyl::HyperDouble fz = Gkyl::quadLeibniz<8>(H, z, Gkyl::HyperDouble(0.0), z*z);
+  double z0 = 1.5, e = std::exp(-z0*z0*z0);
+  REQUIRE( fz.real() == Approx((1-e)/z0) );
+  REQUIRE( fz.inf() == Approx(-(1-e)/(z0*z0) + 3*z0*e) );
+
+  // agrees with differentiating through the node mapping
+  Gkyl::Packed<Gkyl::HyperDouble,8> pz = Gkyl::pack<8>(z);
+  Gkyl::HyperDouble gz = Gkyl::quadPacked<8>(
+    [&](const Gkyl::Packed<Gkyl::HyperDouble,8>& y) { return H(pz, y); },
+    Gkyl::HyperDouble(0.0), z*z);
+  REQUIRE( fz.real() == Approx(gz.real()) );
+  REQUIRE( fz.inf() == Approx(gz.inf()) );
+}
+
+TEST_CASE("Tensor-product quadrature over boxes", "[quad-box]") {
+  // \int_0^1 \int_0^2 exp(a*x) y^2 dy dx, and derivative wrt a
+  Gkyl::HyperDouble a(0.5, 1.0);
+  std::array<Gkyl::HyperDouble,2> lo = { 0.0, 0.0 }, up = { 1.0, 2.0 };
+  Gkyl::HyperDouble res = Gkyl::quadBox<8>(
+    [&](const std::array<Gkyl::HyperDouble,2>& x) { return Gkyl::exp(a*x[0])*x[1]*x[1]; },
+    lo, up);
+  double a0 = 0.5, ea = std::exp(a0);
+  REQUIRE( res.real() == Approx((ea-1)/a0*8.0/3.0) );
+  REQUIRE( res.inf() == Approx(((a0-1)*ea+1)/(a0*a0)*8.0/3.0) );
+
+  // derivative with respect to the box bounds
+  Gkyl::HyperDouble L(2.0, 1.0);
+  std::array<Gkyl::HyperDouble,3> lo3 = { 0.0, 0.0, 0.0 }, up3 = { L, 1.0, 1.0 };
+  Gkyl::HyperDouble vol = Gkyl::quadBox<2>(
+    [](const std::array<Gkyl::HyperDouble,3>& x) { return x[0]*x[1]; },
+    lo3, up3);
+  REQUIRE( vol.real() == Approx(1.0) );
+  REQUIRE( vol.inf() == Approx(1.0) );
+}
+
+TEST_CASE("Sum-factorized moments over boxes", "[quad-moments]") {
+  // compare with direct sum over nodes of w P_k1 P_k2 P_k3 G
+  auto G = [](const std::array<double,3>& x) {
+    return std::cos(x[0]+2*x[1])*std::exp(x[2]) + x[0]*x[1]*x[2];
+  };
+  std::array<double,3> lo = { -1.0, 0.0, 0.5 }, up = { 1.0, 2.0, 1.0 };
+  std::vector<double> mom = Gkyl::quadMomentsBox<4,3>(G, lo, up);
+  REQUIRE( mom.size() == 27 );
+
+  auto leg = [](int k, double x) { return k == 0 ? 1.0 : (k == 1 ? x : 1.5*x*x-0.5); };
+  const Gkyl::GaussLegendre<4>& gl = Gkyl::GaussLegendre<4>::get();
+  double jac = 1.0*1.0*0.25;
+  for (int k1=0; k1<3; ++k1)
+    for (int k2=0; k2<3; ++k2)
+      for (int k3=0; k3<3; ++k3) {
+        double s = 0.0;
+        for (int i=0; i<4; ++i)
+          for (int j=0; j<4; ++j)
+            for (int l=0; l<4; ++l) {
+              double e0 = gl.ordinates()[i], e1 = gl.ordinates()[j], e2 = gl.ordinates()[l];
+              std::array<double,3> x = { e0, 1.0+e1, 0.75+0.25*e2 };
+              s += gl.weights()[i]*gl.weights()[j]*gl.weights()[l]
+                *leg(k1,e0)*leg(k2,e1)*leg(k3,e2)*G(x);
+            }
+        REQUIRE( mom[(k1*3+k2)*3+k3] == Approx(jac*s).margin(1e-14) );
+      }
+}
+
+TEST_CASE("Adaptive Gauss-Kronrod quadrature", "[quad-adaptive]") {
+  // F(e) = \int_0^1 dy/((y-0.3)^2+e), sharply peaked for small e
+  auto F = [](double e) {
+    double se = std::sqrt(e);
+    return (std::atan(0.7/se)+std::atan(0.3/se))/se;
+  };
+  double e0 = 1e-4;
+  Gkyl::HyperDouble e(e0, 1.0);
+  auto G = [&](const Gkyl::HyperDouble& y) { return 1/((y-0.3)*(y-0.3)+e); };
+
+  Gkyl::QuadAdaptiveOpts opts;
+  opts.relTol = 1e-10;
+  Gkyl::QuadAdaptiveStats stats;
+  Gkyl::HyperDouble res = Gkyl::quadAdaptive(G, Gkyl::HyperDouble(0.0), Gkyl::HyperDouble(1.0), opts, &stats);
+  REQUIRE( stats.converged );
+  REQUIRE( stats.nevals <= opts.maxEvals );
+  REQUIRE( res.real() == Approx(F(e0)).epsilon(1e-9) );
+  // dF/de = -\int_0^1 dy/((y-0.3)^2+e)^2
+  double dF = -0.5/e0*(F(e0) + 0.7/(0.49+e0) + 0.3/(0.09+e0));
+  REQUIRE( res.inf() == Approx(dF).epsilon(1e-9) );
+
+  // POD numbers
+  Gkyl::QuadAdaptiveStats pstats;
+  double pres = Gkyl::quadAdaptive([](double y) { return std::exp(-y*y); }, 0.0, 2.0,
+    Gkyl::QuadAdaptiveOpts(), &pstats);
+  REQUIRE( pstats.converged );
+  REQUIRE( pres == Approx(0.882081390762421).epsilon(1e-12) );
+
+  // the estimated error bounds the actual error
+  REQUIRE( std::fabs(res.real()-F(e0)) <= stats.errReal );
+  REQUIRE( std::fabs(res.inf()-dF) <= stats.errInf );
+  REQUIRE( stats.errReal <= std::max(opts.absTol, opts.relTol*std::fabs(res.real())) );
+
+  // each sweep bisects at least one subinterval
+  opts.batch = 0;
+  REQUIRE_THROWS_AS( Gkyl::quadAdaptive(G, Gkyl::HyperDouble(0.0), Gkyl::HyperDouble(1.0), opts),
+    std::invalid_argument );
+}
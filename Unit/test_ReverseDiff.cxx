@@ -0,0 +1,136 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkReverseAutoDiff.h>
+#include <GkDiffCheck.h>
+#include <GkTestFixtures.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+typedef Gkyl::ReverseDouble RD;
+
+TEST_CASE("Reverse derivatives of math functions", "[reverse]") {
+  Gkyl::Tape<double>& tape = Gkyl::Tape<double>::get();
+
+  // adjoint is the derivative worked out by hand
+  RD x = RD::input(5.0), z = testFunc(x);
+  z.gradient();
+  REQUIRE( z.real() == Approx(testFunc(5.0)) );
+  REQUIRE( x.adjoint() == Approx(testFuncDeriv(5.0)) );
+
+  // other results agree with HyperDouble
+  RD y = RD::input(0.5);
+  z = Gkyl::pow(x, y) + Gkyl::hypot(x, y) + Gkyl::atan2(y, x) + Gkyl::pow<3>(x)*Gkyl::tanh(y) - Gkyl::pow(2.0, y);
+  Gkyl::HyperDouble x1(5.0, 1.0), y1(0.5, 0.0), x2(5.0, 0.0), y2(0.5, 1.0);
+  Gkyl::HyperDouble zx = Gkyl::pow(x1, y1) + Gkyl::hypot(x1, y1) + Gkyl::atan2(y1, x1) + Gkyl::pow<3>(x1)*Gkyl::tanh(y1) - Gkyl::pow(2.0, y1);
+  Gkyl::HyperDouble zy = Gkyl::pow(x2, y2) + Gkyl::hypot(x2, y2) + Gkyl::atan2(y2, x2) + Gkyl::pow<3>(x2)*Gkyl::tanh(y2) - Gkyl::pow(2.0, y2);
+  z.gradient();
+  REQUIRE( x.adjoint() == Approx(zx.inf()) );
+  REQUIRE( y.adjoint() == Approx(zy.inf()) );
+
+  // a passive exponent needs no log of the base, so bases <= 0 have
+  // adjoints: (x^3)' = 3x^2
+  RD m = RD::input(-2.0), o = RD::input(0.0);
+  z = Gkyl::pow(m, RD(3.0));
+  z.gradient();
+  REQUIRE( z.real() == -8.0 );
+  REQUIRE( m.adjoint() == Approx(12.0) );
+  z = Gkyl::pow(o, RD(3.0));
+  z.gradient();
+  REQUIRE( o.adjoint() == 0.0 );
+  z = Gkyl::pow(o, RD(1.0));
+  z.gradient();
+  REQUIRE( o.adjoint() == 1.0 );
+  // (0^y)' is zero for y > 0
+  z = Gkyl::pow(RD(0.0), y);
+  z.gradient();
+  REQUIRE( y.adjoint() == 0.0 );
+
+  // compound assignment, and a number used many times
+  RD s = 0.0;
+  for (int i=0; i<10; ++i) s += x*y;
+  s /= y;
+  s.gradient();
+  REQUIRE( s.real() == Approx(50.0) );
+  REQUIRE( x.adjoint() == Approx(10.0) );
+  REQUIRE( y.adjoint() == Approx(0.0).margin(1e-12) );
+
+  // passive numbers are not recorded
+  int n0 = tape.size();
+  RD p = 3.0, q = Gkyl::sin(p)*p + 2.0;
+  REQUIRE( !q.active() );
+  REQUIRE( tape.size() == n0 );
+
+  // rewinding keeps nodes before the position
+  tape.rewind(n0);
+  RD w = x*x;
+  w.gradient();
+  REQUIRE( x.adjoint() == 10.0 );
+
+  // a sweep with a lower bound takes earlier nodes as constants
+  RD u = RD::input(2.0), v = x*u*u;
+  v.gradient(u.index());
+  REQUIRE( u.adjoint() == Approx(20.0) );
+  REQUIRE( x.adjoint() == 0.0 );
+
+  // quotients are rounded once
+  RD a = RD::input(0.3), b = RD::input(0.1), c = a/b, d = a/0.1;
+  REQUIRE( c.real() == 0.3/0.1 );
+  REQUIRE( d.real() == 0.3/0.1 );
+  c.gradient();
+  REQUIRE( a.adjoint() == Approx(10.0) );
+  REQUIRE( b.adjoint() == Approx(-30.0) );
+  tape.rewind();
+  REQUIRE( tape.size() == 0 );
+}
+
+TEST_CASE("Reverse Jacobians", "[reverse-jacobian]") {
+  int n = 12;
+  std::vector<double> x(n), Jr, Jf;
+  for (int j=0; j<n; ++j) x[j] = 0.1*j-0.5;
+  Gkyl::reverseJacobian(CyclicFunc(), x, n, Jr);
+  Gkyl::forwardJacobian(CyclicFunc(), x, n, Jf);
+  REQUIRE( Jr.size() == Jf.size() );
+  for (std::size_t k=0; k<Jr.size(); ++k) REQUIRE( Jr[k] == Approx(Jf[k]) );
+  REQUIRE( Gkyl::Tape<double>::get().size() == 0 );
+
+  // checked against finite differences, from many threads at once
+  Gkyl::DiffCheckOpts opts;
+  opts.npoints = 64;
+  opts.nthreads = 8;
+  Gkyl::DiffCheckResult r = Gkyl::diffCheckJacobian(
+    [](const std::vector<double>& x, std::vector<double>& y) { CyclicFunc()(x, y); },
+    [n](const std::vector<double>& x, std::vector<double>& J) { Gkyl::reverseJacobian(CyclicFunc(), x, n, J); },
+    n, n, opts);
+  REQUIRE( r.nchecked == 64*n*n );
+  REQUIRE( r.maxErr < 1e-8 );
+}
+
+TEST_CASE("Threads record their own tapes", "[reverse-threads]") {
+  // each thread records a different number of nodes, and gets the
+  // gradient of its own function
+  int nt = 8;
+  std::vector<double> grad(nt);
+  std::vector<int> size(nt);
+  std::vector<std::thread> threads;
+  for (int t=0; t<nt; ++t)
+    threads.emplace_back([t, &grad, &size]() {
+        for (int rep=0; rep<100; ++rep) {
+          RD x = RD::input(1.0+t), s = 0.0;
+          for (int k=0; k<=t; ++k) s += x*x;
+          size[t] = Gkyl::Tape<double>::get().size();
+          s.gradient();
+          grad[t] = x.adjoint();
+          Gkyl::Tape<double>::get().rewind();
+        }
+      });
+  for (std::thread& th : threads) th.join();
+  for (int t=0; t<nt; ++t) {
+    REQUIRE( size[t] == 1+2*(t+1) );
+    REQUIRE( grad[t] == Approx(2*(t+1)*(1.0+t)) );
+  }
+  // the tape of this thread is untouched
+  REQUIRE( Gkyl::Tape<double>::get().size() == 0 );
+}
@@ -0,0 +1,134 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch.hpp>
+#include <GkForwardAutoDiff.h>
+#include <GkSparseTangent.h>
+#include <GkPool.h>
+#include <GkProblems.h>
+#include <GkTestFixtures.h>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+typedef Gkyl::SparseTangent<double> ST;
+typedef Gkyl::HyperReal<double,ST> HyperSparse;
+
+TEST_CASE("Entries of SparseTangent", "[sparse-tangent]") {
+  const ST z(0.0);
+  REQUIRE( z.empty() );
+  REQUIRE( z[5] == 0.0 );
+  // no other scalar has a sparse form
+  REQUIRE_THROWS_AS( ST(1.0), std::invalid_argument );
+  static_assert(std::is_nothrow_move_constructible<ST>::value, "");
+  static_assert(std::is_nothrow_move_assignable<ST>::value, "");
+
+  // merge keeps indices sorted and combines equal ones
+  const ST s = ST::unit(7, 2.0) + ST::unit(3, 1.0) - 2.0*ST::unit(7, 0.5);
+  REQUIRE( s.nnz() == 2 );
+  REQUIRE( s.index(0) == 3 );
+  REQUIRE( s.index(1) == 7 );
+  REQUIRE( s[3] == 1.0 );
+  REQUIRE( s[7] == 1.0 );
+  REQUIRE( s[4] == 0.0 );
+
+  // more entries than fit inline come from the pool
+  ST a, b;
+  for (int i=0; i<100; ++i) {
+    a += ST::unit(2*i, 1.0);
+    b += ST::unit(3*i, 2.0);
+  }
+  ST c = a + b;
+  REQUIRE( a.nnz() == 100 );
+  REQUIRE( c.nnz() == 100+100-34 );
+  REQUIRE( c[0] == 3.0 );
+  REQUIRE( c[2] == 1.0 );
+  REQUIRE( c[3] == 2.0 );
+  REQUIRE( c[1] == 0.0 );
+
+  // copies and moves keep the entries
+  ST d(c), e(std::move(c));
+  REQUIRE( c.empty() );
+  REQUIRE( d.nnz() == e.nnz() );
+  for (int k=0; k<d.nnz(); ++k) {
+    REQUIRE( d.index(k) == e.index(k) );
+    REQUIRE( d.value(k) == e.value(k) );
+  }
+  d = a; e = ST::unit(1);
+  REQUIRE( d.nnz() == 100 );
+  REQUIRE( e.nnz() == 1 );
+}
+
+TEST_CASE("Storage of SparseTangent", "[sparse-tangent]") {
+  // up to K = 4 entries are inline and use no block from the pool;
+  // more use one, which goes back to the pool of the thread when the
+  // number does, and is then reused. On a new thread, whose pool is
+  // empty, count the blocks the pool holds after each number is gone
+  std::vector<std::size_t> held;
+  std::thread([&held]() {
+      auto nfree = []() {
+        std::size_t k = 0;
+        for (int c=0; c<40; ++c) k += Gkyl::BlockPool::freeBlocks(c);
+        return k;
+      };
+      for (int m : { 4, 5, 5 }) {
+        {
+          ST s;
+          for (int i=0; i<m; ++i) s += ST::unit(10*i);
+        }
+        held.push_back(nfree());
+      }
+    }).join();
+  REQUIRE( held[0] == 0 );
+  REQUIRE( held[1] == 1 );
+  REQUIRE( held[2] == 1 );
+}
+
+TEST_CASE("HyperReal with SparseTangent", "[sparse-tangent]") {
+  // math functions keep the single entry of the input, and give the
+  // derivative worked out by hand
+  HyperSparse x(5.0, ST::unit(1000)), z = testFunc(x);
+  REQUIRE( z.real() == Approx(testFunc(5.0)) );
+  REQUIRE( z.inf().nnz() == 1 );
+  REQUIRE( z.inf()[1000] == Approx(testFuncDeriv(5.0)) );
+
+  // the entries of a sum are those of its terms: their number grows
+  // with the inputs a quantity depends on, not with all inputs
+  int n = 1000;
+  std::vector<HyperSparse> xs(n);
+  for (int j=0; j<n; ++j) xs[j] = HyperSparse(0.5+0.001*j, ST::unit(j));
+  HyperSparse s = 0.0;
+  for (int k=0; k<20; ++k) {
+    s += xs[50*k]*xs[50*k];
+    REQUIRE( s.inf().nnz() == k+1 );
+  }
+  for (int k=0; k<20; ++k) REQUIRE( s.inf()[50*k] == Approx(2*xs[50*k].real()) );
+  REQUIRE( s.inf()[25] == 0.0 );
+  // entries that cancel are kept, as structural nonzeros
+  HyperSparse t = xs[3] + xs[7] - xs[7];
+  REQUIRE( t.inf().nnz() == 2 );
+  REQUIRE( t.inf()[7] == 0.0 );
+
+  // sparse Jacobian of the 2-D Bratu residual in one sweep: each
+  // output has entries for its 5-point stencil only, 4/h^2 - lambda
+  // exp(u) on the diagonal and -1/h^2 off it
+  Bratu2D p;
+  p.nx = 8;
+  int nx = p.nx, nu = p.nin();
+  double rh2 = (nx+1)*(nx+1);
+  std::vector<HyperSparse> hu(nu), hr(nu);
+  for (int j=0; j<nu; ++j) hu[j] = HyperSparse(p.x0(j), ST::unit(j));
+  p.eval(hu, hr);
+  for (int k=0; k<nu; ++k) {
+    const ST d = hr[k].inf();
+    int i = k/nx, j = k%nx;
+    int nb = (i > 0) + (i < nx-1) + (j > 0) + (j < nx-1);
+    REQUIRE( d.nnz() == 1+nb );
+    REQUIRE( d[k] == Approx(4*rh2 - p.lambda*std::exp(p.x0(k))) );
+    if (i > 0) REQUIRE( d[k-nx] == Approx(-rh2) );
+    if (i < nx-1) REQUIRE( d[k+nx] == Approx(-rh2) );
+    if (j > 0) REQUIRE( d[k-1] == Approx(-rh2) );
+    if (j < nx-1) REQUIRE( d[k+1] == Approx(-rh2) );
+  }
+}